@@ -8,10 +8,32 @@ enum
 	PROJECTOR_MODE                = 10002,      // LONG CYCLE
 		PROJECTOR_MODE_PARALLEL       = 1,          // CYCLE VALUE
 		PROJECTOR_MODE_SPHERICAL      = 2,          // CYCLE VALUE
+		PROJECTOR_MODE_CLOSEST        = 3,          // CYCLE VALUE
 	PROJECTOR_OFFSET              = 10003,      // REAL
 	PROJECTOR_BLEND               = 10004,      // REAL
 	PROJECTOR_GEOMFALLOFF_ENABLE  = 10005,      // BOOL
-	PROJECTOR_GEOMFALLOFF_DIST    = 10006       // REAL
+	PROJECTOR_GEOMFALLOFF_DIST    = 10006,      // REAL
+	PROJECTOR_MAXDIST_ENABLE      = 10007,      // BOOL
+	PROJECTOR_MAXDIST             = 10008,      // REAL
+	PROJECTOR_SDF_ENABLE          = 10009,      // BOOL
+	PROJECTOR_SDF_RESOLUTION      = 10010,      // LONG
+	PROJECTOR_DIRECTION           = 10011,      // LONG CYCLE
+		PROJECTOR_DIRECTION_FORWARD        = 0,     // CYCLE VALUE
+		PROJECTOR_DIRECTION_BOTH_NEAREST   = 1,     // CYCLE VALUE
+		PROJECTOR_DIRECTION_BOTH_FORWARD   = 2,     // CYCLE VALUE
+	PROJECTOR_EDITOR_QUALITY      = 10012,      // REAL
+	PROJECTOR_PROGRESSIVE         = 10013,      // BOOL
+	PROJECTOR_CAPTURE_FILE        = 10014,      // FILENAME
+	PROJECTOR_CAPTURE             = 10015,      // BUTTON
+	PROJECTOR_SPLINE_ADAPTIVE     = 10016,      // BOOL
+	PROJECTOR_SPLINE_TOLERANCE    = 10017,      // REAL
+	PROJECTOR_SPLINE_MAXDEPTH     = 10018,      // LONG
+	PROJECTOR_BAKE_FILE           = 10019,      // FILENAME
+	PROJECTOR_BAKE_FROM           = 10020,      // LONG
+	PROJECTOR_BAKE_TO             = 10021,      // LONG
+	PROJECTOR_BAKE                = 10022,      // BUTTON
+	PROJECTOR_BAKE_USE            = 10023,      // BOOL
+	PROJECTOR_BAKE_PRECISION      = 10024       // REAL
 };
 
 #endif
@@ -14,6 +14,16 @@ CONTAINER oProjector
 			{
 				PROJECTOR_MODE_PARALLEL;
 				PROJECTOR_MODE_SPHERICAL;
+				PROJECTOR_MODE_CLOSEST;
+			}
+		}
+		LONG  PROJECTOR_DIRECTION
+		{
+			CYCLE
+			{
+				PROJECTOR_DIRECTION_FORWARD;
+				PROJECTOR_DIRECTION_BOTH_NEAREST;
+				PROJECTOR_DIRECTION_BOTH_FORWARD;
 			}
 		}
 		REAL  PROJECTOR_OFFSET      { UNIT METER; MINSLIDER -50.0; MAXSLIDER 50.0; CUSTOMGUI REALSLIDER; }
@@ -21,5 +31,31 @@ CONTAINER oProjector
 
 		BOOL  PROJECTOR_GEOMFALLOFF_ENABLE  {  }
 		REAL  PROJECTOR_GEOMFALLOFF_DIST    { UNIT METER; MIN 0.0; STEP 1.0; }
+
+		BOOL  PROJECTOR_MAXDIST_ENABLE      {  }
+		REAL  PROJECTOR_MAXDIST             { UNIT METER; MIN 0.0; STEP 1.0; }
+
+		BOOL  PROJECTOR_SDF_ENABLE          {  }
+		LONG  PROJECTOR_SDF_RESOLUTION      { MIN 8; MAX 1024; }
+
+		BOOL  PROJECTOR_SPLINE_ADAPTIVE     {  }
+		REAL  PROJECTOR_SPLINE_TOLERANCE    { UNIT METER; MIN 0.001; STEP 0.1; }
+		LONG  PROJECTOR_SPLINE_MAXDEPTH     { MIN 1; MAX 16; }
+
+		SEPARATOR { LINE; }
+		REAL  PROJECTOR_EDITOR_QUALITY      { UNIT PERCENT; MIN 1.0; MAX 100.0; CUSTOMGUI REALSLIDER; }
+		BOOL  PROJECTOR_PROGRESSIVE         {  }
+
+		SEPARATOR { LINE; }
+		FILENAME PROJECTOR_CAPTURE_FILE     { SAVE; }
+		BUTTON PROJECTOR_CAPTURE            {  }
+
+		SEPARATOR { LINE; }
+		FILENAME PROJECTOR_BAKE_FILE        { SAVE; }
+		LONG  PROJECTOR_BAKE_FROM           {  }
+		LONG  PROJECTOR_BAKE_TO             {  }
+		REAL  PROJECTOR_BAKE_PRECISION      { UNIT METER; MIN 0.0001; STEP 0.01; }
+		BUTTON PROJECTOR_BAKE               {  }
+		BOOL  PROJECTOR_BAKE_USE            {  }
 	}
 }
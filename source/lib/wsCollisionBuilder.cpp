@@ -0,0 +1,248 @@
+#include "maxon/apibase.h"
+#include "wsCollisionBuilder.h"
+#include "wsFunctions.h"
+
+
+static const Float64 BUILD_KEEP_FRACTION = 0.5;  ///< A running build is not cancelled anymore once it took this fraction of the last build's duration
+
+
+Bool wsCollisionCache::Build(BaseObject *source, const BaseObject *linkedObject, PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, UInt64 checksum, BaseThread *thread)
+{
+	if (!source || _geometry)
+		return false;
+
+	// Get polygon geometry. Polygon objects are simply copied, everything else is converted.
+	if (source->GetType() == Opolygon)
+		_geometry = static_cast<PolygonObject*>(source->GetClone(COPYFLAGS::NONE, nullptr));
+	else
+		_geometry = GetRealGeometry(source);
+
+	// No chance, we give up
+	if (!_geometry)
+		return false;
+	if (_geometry->GetType() != Opolygon)
+	{
+		PolygonObject::Free(_geometry);
+		return false;
+	}
+
+	if (thread && thread->TestBreak())
+		return false;
+
+	// Initialize projector, this builds the GeRayCollider
+	if (!_projector.Init(_geometry, true))
+		return false;
+
+	if (thread && thread->TestBreak())
+		return false;
+
+	// Build everything else the projection mode needs
+	if (!_projector.BuildCollisionCaches(mode, direction, sdfResolution, smoothNormals, thread))
+		return false;
+
+	_hasHierarchy = wsPointProjector::NeedsCollisionHierarchy(mode, direction);
+	_hasNormals = wsPointProjector::NeedsCollisionMesh(mode, direction, smoothNormals);
+	_sdfResolution = mode == PROJECTORMODE::CLOSESTPOINT ? sdfResolution : 0;
+	_checksum = checksum;
+	_linkedObject = linkedObject;
+	return true;
+}
+
+Bool wsCollisionCache::Supports(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals) const
+{
+	if (!_geometry)
+		return false;
+
+	// Closest point mode and bidirectional rays query the collision mesh, smooth normals only need its vertex normals
+	if (wsPointProjector::NeedsCollisionHierarchy(mode, direction) && !_hasHierarchy)
+		return false;
+	if (smoothNormals && !_hasNormals)
+		return false;
+
+	// The distance field must have the requested resolution
+	if (mode == PROJECTORMODE::CLOSESTPOINT && sdfResolution > 0 && sdfResolution != _sdfResolution)
+		return false;
+
+	return true;
+}
+
+Bool wsCollisionCache::Extend(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, BaseThread *thread)
+{
+	if (!_geometry)
+		return false;
+
+	// Structures that already exist are not built again
+	if (!_projector.BuildCollisionCaches(mode, direction, sdfResolution, smoothNormals, thread))
+		return false;
+
+	_hasHierarchy = _hasHierarchy || wsPointProjector::NeedsCollisionHierarchy(mode, direction);
+	_hasNormals = _hasNormals || wsPointProjector::NeedsCollisionMesh(mode, direction, smoothNormals);
+	if (mode == PROJECTORMODE::CLOSESTPOINT)
+		_sdfResolution = sdfResolution;
+	return true;
+}
+
+void wsCollisionCache::SetMg(const Matrix &mg)
+{
+	if (_geometry)
+		_geometry->SetMg(mg);
+}
+
+wsCollisionCache::~wsCollisionCache()
+{
+	PolygonObject::Free(_geometry);
+}
+
+
+void wsCollisionBuilder::FreeRequest(BuildRequest &request)
+{
+	// The document owns the cloned object
+	BaseDocument::Free(request._document);
+	request._source = nullptr;
+}
+
+Bool wsCollisionBuilder::RequestBuild(BaseObject *linkedObject, PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, UInt64 checksum)
+{
+	if (!linkedObject)
+		return false;
+
+	// Clone the linked object into a temporary document, the background thread must not access the original document
+	AutoAlloc<AliasTrans> aliasTrans;
+	if (!aliasTrans || !aliasTrans->Init(linkedObject->GetDocument()))
+		return false;
+
+	BuildRequest request;
+	request._source = static_cast<BaseObject*>(linkedObject->GetClone(COPYFLAGS::NONE, aliasTrans));
+	if (!request._source)
+		return false;
+	aliasTrans->Translate(true);
+
+	request._document = BaseDocument::Alloc();
+	if (!request._document)
+	{
+		BaseObject::Free(request._source);
+		return false;
+	}
+	request._document->InsertObject(request._source, nullptr, nullptr);
+	request._linkedObject = linkedObject;
+
+	request._mode = mode;
+	request._direction = direction;
+	request._sdfResolution = sdfResolution;
+	request._smoothNormals = smoothNormals;
+	request._checksum = checksum;
+
+	// Increasing the generation cancels the running build. One that is about to finish is kept, its result bridges the time until the new one is done.
+	request._generation = IsNearlyFinished() ? _generation.LoadRelaxed() : _generation.SwapIncrement() + 1;
+
+	// Replace the request that has not been started yet, if any
+	{
+		maxon::ScopedLock lock(_lock);
+		FreeRequest(_pending);
+		_pending = request;
+	}
+
+	StartPending();
+	return true;
+}
+
+void wsCollisionBuilder::StartPending()
+{
+	// The running build will notice it has been cancelled, and the pending request is started the next time
+	if (IsRunning())
+		return;
+
+	{
+		maxon::ScopedLock lock(_lock);
+		if (!_pending._source)
+			return;
+	}
+
+	Start(THREADMODE::ASYNC, THREADPRIORITYEX::BELOW);
+}
+
+Bool wsCollisionBuilder::IsNearlyFinished()
+{
+	if (!IsRunning())
+		return false;
+
+	maxon::ScopedLock lock(_lock);
+	return _lastBuildDuration > 0.0 && GeGetMilliSeconds() - _buildStart >= _lastBuildDuration * BUILD_KEEP_FRACTION;
+}
+
+Bool wsCollisionBuilder::HasResult()
+{
+	maxon::ScopedLock lock(_lock);
+	return _result != nullptr;
+}
+
+wsCollisionCache *wsCollisionBuilder::TakeResult()
+{
+	maxon::ScopedLock lock(_lock);
+	wsCollisionCache *result = _result;
+	_result = nullptr;
+	return result;
+}
+
+void wsCollisionBuilder::Cancel()
+{
+	_generation.SwapIncrement();
+	End(true);
+
+	maxon::ScopedLock lock(_lock);
+	FreeRequest(_pending);
+	DeleteObj(_result);
+}
+
+void wsCollisionBuilder::Main()
+{
+	// Take the pending request
+	BuildRequest request;
+	const Float64 buildStart = GeGetMilliSeconds();
+	{
+		maxon::ScopedLock lock(_lock);
+		request = _pending;
+		_pending = BuildRequest();
+		_buildStart = buildStart;
+	}
+	if (!request._source)
+		return;
+
+	_buildGeneration = request._generation;
+
+	// Build the cache. If the request is outdated, TestDBreak() cancels the build.
+	wsCollisionCache *cache = NewObjClear(wsCollisionCache);
+	Bool success = cache && cache->Build(request._source, request._linkedObject, request._mode, request._direction, request._sdfResolution, request._smoothNormals, request._checksum, Get()) && !TestBreak();
+	FreeRequest(request);
+
+	// Publish the result, replacing an older one that has not been taken yet. Its duration helps to decide if the next build is worth waiting for.
+	if (success)
+	{
+		maxon::ScopedLock lock(_lock);
+		DeleteObj(_result);
+		_result = cache;
+		_lastBuildDuration = GeGetMilliSeconds() - buildStart;
+	}
+	else
+	{
+		DeleteObj(cache);
+	}
+
+	// Wake up the main thread, it will take the result or start the next request
+	EventAdd();
+}
+
+const Char *wsCollisionBuilder::GetThreadName()
+{
+	return "wsCollisionBuilder";
+}
+
+Bool wsCollisionBuilder::TestDBreak()
+{
+	return _generation.LoadRelaxed() != _buildGeneration;
+}
+
+wsCollisionBuilder::~wsCollisionBuilder()
+{
+	Cancel();
+}
@@ -0,0 +1,155 @@
+#ifndef WS_COLLISIONBUILDER_H__
+#define WS_COLLISIONBUILDER_H__
+
+
+#include "c4d.h"
+#include "maxon/spinlock.h"
+#include "maxon/atomictypes.h"
+#include "wsPointProjector.h"
+
+
+/// Collision geometry, and a wsPointProjector with all acceleration structures built for it
+class wsCollisionCache
+{
+private:
+	PolygonObject     *_geometry;       ///< Polygon geometry of the linked object, in the linked object's local space. Owned by the cache.
+	const BaseObject  *_linkedObject;   ///< The linked object the cache has been built for. Only compared, never dereferenced.
+	wsPointProjector   _projector;      ///< Projector, initialized with _geometry
+	UInt64             _checksum;       ///< Checksum of the input this cache was built from
+	Bool               _hasHierarchy;   ///< Indicates if the collision mesh has been built with hierarchy
+	Bool               _hasNormals;     ///< Indicates if the collision mesh has been built, at least its vertex normals
+	Int32              _sdfResolution;  ///< Resolution of the signed distance field that has been built, or 0
+
+public:
+	/// Convert an object to polygons, and build the acceleration structures
+	/// @param source The object to build the cache for. If it's not a polygon object, its current state is used. The object is not changed.
+	/// @param linkedObject The linked object in the document, source might be a clone of it. Can be retrieved later with GetLinkedObject().
+	/// @param mode Projection mode
+	/// @param direction Ray direction
+	/// @param sdfResolution Resolution of the signed distance field in closest point mode, 0 means no field is used
+	/// @param smoothNormals True if hit normals are needed (e.g. for the offset)
+	/// @param checksum Checksum of the input, can be retrieved later with GetChecksum()
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem or processing was cancelled, otherwise true
+	Bool Build(BaseObject *source, const BaseObject *linkedObject, PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, UInt64 checksum, BaseThread *thread = nullptr);
+
+	/// Finds out if the cache contains everything that's needed for a projection mode, so no acceleration structures have to be built during projection
+	Bool Supports(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals) const;
+
+	/// Build the acceleration structures a projection mode needs, but which are missing in the cache. The geometry stays the same.
+	/// @param mode Projection mode
+	/// @param direction Ray direction
+	/// @param sdfResolution Resolution of the signed distance field in closest point mode, 0 means no field is used
+	/// @param smoothNormals True if hit normals are needed (e.g. for the offset)
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem or processing was cancelled, otherwise true
+	Bool Extend(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, BaseThread *thread = nullptr);
+
+	/// Moves the collision geometry to the current position of the linked object
+	/// @param mg Global matrix of the linked object
+	void SetMg(const Matrix &mg);
+
+	/// @return The projector
+	wsPointProjector &GetProjector()
+	{
+		return _projector;
+	}
+
+	/// @return The polygon geometry, in the linked object's local space
+	const PolygonObject *GetGeometry() const
+	{
+		return _geometry;
+	}
+
+	/// @return The checksum passed to Build()
+	UInt64 GetChecksum() const
+	{
+		return _checksum;
+	}
+
+	/// @return The linked object passed to Build(). Only to be compared, it might not exist anymore.
+	const BaseObject *GetLinkedObject() const
+	{
+		return _linkedObject;
+	}
+
+	/// Default constructor
+	wsCollisionCache() : _geometry(nullptr), _linkedObject(nullptr), _checksum(0), _hasHierarchy(false), _hasNormals(false), _sdfResolution(0)
+	{ }
+
+	/// Destructor
+	~wsCollisionCache();
+};
+
+
+/// Builds a wsCollisionCache in a background thread, so the editor doesn't block while heavy geometry is converted and the acceleration structures are built.
+/// A new request cancels the build that is currently running, unless that one is about to finish.
+class wsCollisionBuilder : public C4DThread
+{
+private:
+	/// A build request
+	struct BuildRequest
+	{
+		BaseDocument       *_document = nullptr;                         ///< Temporary document that contains a clone of the linked object
+		BaseObject         *_source = nullptr;                           ///< Clone of the linked object
+		const BaseObject   *_linkedObject = nullptr;                     ///< The linked object itself. Only compared, never dereferenced.
+		PROJECTORMODE       _mode = PROJECTORMODE::PARALLEL;             ///< Projection mode
+		PROJECTORDIRECTION  _direction = PROJECTORDIRECTION::FORWARD;   ///< Ray direction
+		Int32               _sdfResolution = 0;                          ///< Resolution of the signed distance field
+		Bool                _smoothNormals = false;                      ///< Indicates if hit normals are needed
+		UInt64              _checksum = 0;                               ///< Checksum of the input
+		Int32               _generation = 0;                             ///< Generation of the request
+	};
+
+	maxon::Spinlock       _lock;               ///< Protects _pending, _result, _buildStart and _lastBuildDuration
+	BuildRequest          _pending;            ///< Request that has not been started yet
+	wsCollisionCache     *_result;             ///< Finished cache that has not been taken yet
+	maxon::AtomicInt32    _generation;         ///< Increased with each request. A build is cancelled when it's not the latest request anymore.
+	Int32                 _buildGeneration;    ///< Generation of the request that is currently being built
+	Float64               _buildStart;         ///< Time (GeGetMilliSeconds()) the current build was started
+	Float64               _lastBuildDuration;  ///< Time in milliseconds the last successful build took, or 0.0
+
+	/// Free the temporary document of a request
+	static void FreeRequest(BuildRequest &request);
+
+	/// Estimates from the duration of the last build if the running build is about to finish
+	/// @return True if a build is running, and it's likely to finish soon
+	Bool IsNearlyFinished();
+
+public:
+	/// Request a new build, and cancel the one that is currently running. A build that is about to finish is not cancelled, the new one starts after it. Must be called from the main thread.
+	/// @param linkedObject The object to build the cache for. A clone is created, so the original object is not accessed by the background thread.
+	/// @param mode Projection mode
+	/// @param direction Ray direction
+	/// @param sdfResolution Resolution of the signed distance field in closest point mode, 0 means no field is used
+	/// @param smoothNormals True if hit normals are needed (e.g. for the offset)
+	/// @param checksum Checksum of the input, can be retrieved from the result with wsCollisionCache::GetChecksum()
+	/// @return False if the object could not be cloned, otherwise true
+	Bool RequestBuild(BaseObject *linkedObject, PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, UInt64 checksum);
+
+	/// Start the pending request, if the thread is not busy. Should be called regularly from the main thread, e.g. in CheckDirty().
+	void StartPending();
+
+	/// @return True if a finished cache is waiting to be taken
+	Bool HasResult();
+
+	/// Take the finished cache
+	/// @return The cache, or nullptr if there is none. The caller owns the pointed object.
+	wsCollisionCache *TakeResult();
+
+	/// Cancel the running build, and free all pending data. Waits for the thread to finish.
+	void Cancel();
+
+	virtual void Main();
+	virtual const Char *GetThreadName();
+	virtual Bool TestDBreak();
+
+	/// Default constructor
+	wsCollisionBuilder() : _result(nullptr), _buildGeneration(0), _buildStart(0.0), _lastBuildDuration(0.0)
+	{ }
+
+	/// Destructor
+	~wsCollisionBuilder();
+};
+
+#endif // WS_COLLISIONBUILDER_H__
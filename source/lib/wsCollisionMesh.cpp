@@ -0,0 +1,1042 @@
+#include "maxon/apibase.h"
+#include "wsCollisionMesh.h"
+#include "wsFunctions.h"
+
+
+static const Int32 BVH_MAX_DEPTH = 48;      ///< Nodes deeper than this will always become leaves. Also determines the traversal stack size.
+static const Int32 BVH_MAX_LEAF_SIZE = 8;   ///< Leaves with more triangles than this will always be split (if possible)
+static const Int32 BVH_BIN_COUNT = 16;      ///< Number of bins used to evaluate split candidates
+
+
+/// Compute a hash of all points and polygons of a PolygonObject, and of the phong and normal tags that determine its vertex normals
+static UInt64 GetGeometryFingerprint(const PolygonObject *polyObject)
+{
+	const Int32 pointCount = polyObject->GetPointCount();
+	const Int32 polyCount = polyObject->GetPolygonCount();
+
+	UInt64 hash = HashMemory(&pointCount, sizeof(pointCount));
+	hash = HashMemory(&polyCount, sizeof(polyCount), hash);
+	if (pointCount > 0)
+		hash = HashMemory(polyObject->GetPointR(), sizeof(Vector) * pointCount, hash);
+	if (polyCount > 0)
+		hash = HashMemory(polyObject->GetPolygonR(), sizeof(CPolygon) * polyCount, hash);
+
+	BaseTag *phongTag = const_cast<PolygonObject*>(polyObject)->GetTag(Tphong);
+	if (phongTag)
+	{
+		const BaseContainer *bc = phongTag->GetDataInstance();
+		const Bool angleLimit = bc->GetBool(PHONGTAG_PHONG_ANGLELIMIT);
+		const Float angle = bc->GetFloat(PHONGTAG_PHONG_ANGLE);
+		const Bool useEdges = bc->GetBool(PHONGTAG_PHONG_USEEDGES);
+		hash = HashMemory(&angleLimit, sizeof(angleLimit), hash);
+		hash = HashMemory(&angle, sizeof(angle), hash);
+		hash = HashMemory(&useEdges, sizeof(useEdges), hash);
+	}
+
+	const VariableTag *normalTag = static_cast<const VariableTag*>(const_cast<PolygonObject*>(polyObject)->GetTag(Tnormal));
+	if (normalTag && normalTag->GetLowlevelDataAddressR())
+		hash = HashMemory(normalTag->GetLowlevelDataAddressR(), (Int)normalTag->GetDataCount() * normalTag->GetDataSize(), hash);
+
+	return hash;
+}
+
+/// Combine the dirty counts of a PolygonObject and the tags that determine its vertex normals. Much cheaper than GetGeometryFingerprint(), but only meaningful for the same object.
+static UInt64 GetGeometryDirtyness(const PolygonObject *polyObject)
+{
+	BaseTag *phongTag = const_cast<PolygonObject*>(polyObject)->GetTag(Tphong);
+	BaseTag *normalTag = const_cast<PolygonObject*>(polyObject)->GetTag(Tnormal);
+
+	// Tag pointers are included, so adding or removing a tag counts as a change
+	const UInt32 objectDirty = polyObject->GetDirty(DIRTYFLAGS::DATA);
+	const UInt32 phongDirty = phongTag ? phongTag->GetDirty(DIRTYFLAGS::DATA) : 0;
+	const UInt32 normalDirty = normalTag ? normalTag->GetDirty(DIRTYFLAGS::DATA) : 0;
+	UInt64 hash = HashMemory(&objectDirty, sizeof(objectDirty));
+	hash = HashMemory(&phongTag, sizeof(phongTag), hash);
+	hash = HashMemory(&phongDirty, sizeof(phongDirty), hash);
+	hash = HashMemory(&normalTag, sizeof(normalTag), hash);
+	hash = HashMemory(&normalDirty, sizeof(normalDirty), hash);
+	return hash;
+}
+
+/// Squared distance between a position and an axis aligned box. Returns 0.0 if the position is inside the box.
+static inline Float DistanceSquaredToBox(const Vector &p, const Vector &boxMin, const Vector &boxMax)
+{
+	Float result = 0.0;
+	if (p.x < boxMin.x)
+		result += Sqr(boxMin.x - p.x);
+	else if (p.x > boxMax.x)
+		result += Sqr(p.x - boxMax.x);
+	if (p.y < boxMin.y)
+		result += Sqr(boxMin.y - p.y);
+	else if (p.y > boxMax.y)
+		result += Sqr(p.y - boxMax.y);
+	if (p.z < boxMin.z)
+		result += Sqr(boxMin.z - p.z);
+	else if (p.z > boxMax.z)
+		result += Sqr(p.z - boxMax.z);
+	return result;
+}
+
+/// Component-wise minimum of two vectors
+static inline Vector VectorMin(const Vector &a, const Vector &b)
+{
+	return Vector(Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z));
+}
+
+/// Component-wise maximum of two vectors
+static inline Vector VectorMax(const Vector &a, const Vector &b)
+{
+	return Vector(Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z));
+}
+
+/// Surface area of an axis aligned box, used to estimate the cost of a BVH split
+static inline Float GetBoxArea(const Vector &boxMin, const Vector &boxMax)
+{
+	const Vector size = boxMax - boxMin;
+	return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/// Closest point on a triangle (see Ericson, "Real-Time Collision Detection", 5.1.5)
+/// @param u Receives the barycentric weight of b
+/// @param v Receives the barycentric weight of c
+static Vector ClosestPointOnTriangle(const Vector &p, const Vector &a, const Vector &b, const Vector &c, Float &u, Float &v)
+{
+	const Vector ab = b - a;
+	const Vector ac = c - a;
+
+	// Vertex region A
+	const Vector ap = p - a;
+	const Float d1 = Dot(ab, ap);
+	const Float d2 = Dot(ac, ap);
+	if (d1 <= 0.0 && d2 <= 0.0)
+	{
+		u = 0.0;
+		v = 0.0;
+		return a;
+	}
+
+	// Vertex region B
+	const Vector bp = p - b;
+	const Float d3 = Dot(ab, bp);
+	const Float d4 = Dot(ac, bp);
+	if (d3 >= 0.0 && d4 <= d3)
+	{
+		u = 1.0;
+		v = 0.0;
+		return b;
+	}
+
+	// Edge region AB
+	const Float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+	{
+		const Float t = d1 / (d1 - d3);
+		u = t;
+		v = 0.0;
+		return a + ab * t;
+	}
+
+	// Vertex region C
+	const Vector cp = p - c;
+	const Float d5 = Dot(ab, cp);
+	const Float d6 = Dot(ac, cp);
+	if (d6 >= 0.0 && d5 <= d6)
+	{
+		u = 0.0;
+		v = 1.0;
+		return c;
+	}
+
+	// Edge region AC
+	const Float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+	{
+		const Float t = d2 / (d2 - d6);
+		u = 0.0;
+		v = t;
+		return a + ac * t;
+	}
+
+	// Edge region BC
+	const Float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+	{
+		const Float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		u = 1.0 - t;
+		v = t;
+		return b + (c - b) * t;
+	}
+
+	// Face region
+	const Float denom = 1.0 / (va + vb + vc);
+	u = vb * denom;
+	v = vc * denom;
+	return a + ab * u + ac * v;
+}
+
+/// Intersect a line with a triangle (Moeller-Trumbore), both sides of the triangle are hit
+/// @param t Receives the parameter of the intersection along the line
+/// @param u Receives the barycentric weight of b
+/// @param v Receives the barycentric weight of c
+static inline Bool IntersectTriangle(const Vector &origin, const Vector &direction, const Vector &a, const Vector &b, const Vector &c, Float &t, Float &u, Float &v)
+{
+	const Vector ab = b - a;
+	const Vector ac = c - a;
+	const Vector p = Cross(direction, ac);
+	const Float determinant = Dot(ab, p);
+	if (determinant == 0.0)
+		return false;
+
+	const Float inverseDeterminant = 1.0 / determinant;
+	const Vector s = origin - a;
+	u = Dot(s, p) * inverseDeterminant;
+	if (u < 0.0 || u > 1.0)
+		return false;
+
+	const Vector q = Cross(s, ab);
+	v = Dot(direction, q) * inverseDeterminant;
+	if (v < 0.0 || u + v > 1.0)
+		return false;
+
+	t = Dot(ac, q) * inverseDeterminant;
+	return true;
+}
+
+/// Intersect a line with an axis aligned box
+/// @param direction Direction of the line. Axes where it is zero are tested explicitly, multiplying by their infinite inverse would give NaN for an origin right on a box plane.
+/// @param inverseDirection Component-wise inverse of direction
+/// @param tNear Receives the parameter where the line enters the box
+/// @param tFar Receives the parameter where the line leaves the box
+/// @return False if the line misses the box, otherwise true
+static inline Bool IntersectBox(const Vector &origin, const Vector &direction, const Vector &inverseDirection, const Vector &boxMin, const Vector &boxMax, Float &tNear, Float &tFar)
+{
+	tNear = maxon::LIMIT<Float>::MIN;
+	tFar = maxon::LIMIT<Float>::MAX;
+	for (Int32 axis = 0; axis < 3; ++axis)
+	{
+		// A line parallel to the slab is either always inside of it, or never
+		if (direction[axis] == 0.0)
+		{
+			if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+				return false;
+			continue;
+		}
+
+		const Float t1 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+		const Float t2 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+		tNear = Max(tNear, Min(t1, t2));
+		tFar = Min(tFar, Max(t1, t2));
+	}
+	return tNear <= tFar;
+}
+
+/// Copy the elements of an array into the order given by an index array
+template <typename T> static Bool ReorderArray(maxon::BaseArray<T> &array, const maxon::BaseArray<Int32> &order)
+{
+	maxon::BaseArray<T> sorted;
+	iferr (sorted.Resize(order.GetCount()))
+		return false;
+
+	for (Int i = 0; i < order.GetCount(); ++i)
+		sorted[i] = array[order[i]];
+
+	array = std::move(sorted);
+	return true;
+}
+
+
+Bool wsCollisionMesh::Init(const PolygonObject *polyObject, Bool force, Bool withHierarchy, BaseThread *thread)
+{
+	if (!polyObject)
+	{
+		Reset();
+		return false;
+	}
+
+	// Nothing to do if it's the same object, and it hasn't been touched since. This is checked on every evaluation, so it must be cheap.
+	const UInt64 dirtyness = GetGeometryDirtyness(polyObject);
+	const Bool hierarchyMissing = withHierarchy && !HasHierarchy();
+	if (!force && _initialized && polyObject == _source && dirtyness == _dirtyness && !hierarchyMissing)
+		return true;
+
+	// Nothing to rebuild if the geometry didn't change, e.g. if the object has only been dirtied by a parameter that doesn't affect it.
+	// The hierarchy might still be missing, if it wasn't requested before.
+	const UInt64 fingerprint = GetGeometryFingerprint(polyObject);
+	if (!force && _initialized && fingerprint == _fingerprint)
+	{
+		if (hierarchyMissing && (!BuildHierarchy(thread) || !BuildPolygonLookup()))
+		{
+			Reset();
+			return false;
+		}
+
+		_source = polyObject;
+		_dirtyness = dirtyness;
+		return true;
+	}
+
+	Reset();
+
+	// Vertex normals are computed before triangulating, they need the neighbours of each polygon
+	maxon::BaseArray<Vector32> cornerNormals;
+	if (!GetCornerNormals(polyObject, cornerNormals) || !Build(polyObject, nullptr, polyObject->GetPolygonCount(), cornerNormals.GetFirst(), withHierarchy, thread))
+	{
+		Reset();
+		return false;
+	}
+
+	_fingerprint = fingerprint;
+	_source = polyObject;
+	_dirtyness = dirtyness;
+	_initialized = true;
+	return true;
+}
+
+Bool wsCollisionMesh::InitPart(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, const Vector32 *cornerNormals, BaseThread *thread)
+{
+	Reset();
+	if (!polyObject || !polygons || !cornerNormals || !Build(polyObject, polygons, polygonCount, cornerNormals, true, thread))
+	{
+		Reset();
+		return false;
+	}
+
+	// There's no object that could be checked for changes later, the fingerprint only has to tell parts apart
+	const Int triangleBytes = (Int)GetTriangleCount() * sizeof(Vector);
+	_fingerprint = HashMemory(_p0.GetFirst(), triangleBytes);
+	_fingerprint = HashMemory(_p1.GetFirst(), triangleBytes, _fingerprint);
+	_fingerprint = HashMemory(_p2.GetFirst(), triangleBytes, _fingerprint);
+	_initialized = true;
+	return true;
+}
+
+Bool wsCollisionMesh::GetCornerNormals(const PolygonObject *polyObject, maxon::BaseArray<Vector32> &cornerNormals)
+{
+	if (!polyObject)
+		return false;
+
+	const Int32 pointCount = polyObject->GetPointCount();
+	const Int32 polyCount = polyObject->GetPolygonCount();
+	const Vector *padr = polyObject->GetPointR();
+	const CPolygon *vadr = polyObject->GetPolygonR();
+	if (pointCount == 0 || polyCount == 0 || !padr || !vadr)
+		return false;
+
+	iferr (cornerNormals.Resize((Int)polyCount * 4))
+		return false;
+
+	// Phong normals respect the phong angle and normal tags, the same way the surface is rendered
+	Vector32 *phongNormals = const_cast<PolygonObject*>(polyObject)->CreatePhongNormals();
+	if (phongNormals)
+	{
+		for (Int i = 0; i < (Int)polyCount * 4; ++i)
+			cornerNormals[i] = phongNormals[i].GetNormalized();
+		DeleteMem(phongNormals);
+		return true;
+	}
+
+	// They're only available with a phong tag, otherwise use area weighted face normals accumulated at each point
+	maxon::BaseArray<Vector> pointNormals;
+	iferr (pointNormals.Resize(pointCount))
+		return false;
+
+	for (Int32 i = 0; i < polyCount; ++i)
+	{
+		const CPolygon &poly = vadr[i];
+		const Vector normal = Cross(padr[poly.b] - padr[poly.a], padr[poly.c] - padr[poly.a]);
+		pointNormals[poly.a] += normal;
+		pointNormals[poly.b] += normal;
+		pointNormals[poly.c] += normal;
+		if (poly.c != poly.d)
+		{
+			const Vector normal2 = Cross(padr[poly.c] - padr[poly.a], padr[poly.d] - padr[poly.a]);
+			pointNormals[poly.a] += normal2;
+			pointNormals[poly.c] += normal2;
+			pointNormals[poly.d] += normal2;
+		}
+	}
+	for (Int32 i = 0; i < pointCount; ++i)
+		pointNormals[i].Normalize();
+
+	for (Int32 i = 0; i < polyCount; ++i)
+	{
+		const CPolygon &poly = vadr[i];
+		Vector32 *polygonNormals = cornerNormals.GetFirst() + (Int)i * 4;
+		polygonNormals[0] = Vector32(pointNormals[poly.a]);
+		polygonNormals[1] = Vector32(pointNormals[poly.b]);
+		polygonNormals[2] = Vector32(pointNormals[poly.c]);
+		polygonNormals[3] = Vector32(pointNormals[poly.d]);
+	}
+
+	return true;
+}
+
+Bool wsCollisionMesh::Build(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, const Vector32 *cornerNormals, Bool withHierarchy, BaseThread *thread)
+{
+	const Vector *padr = polyObject->GetPointR();
+	const CPolygon *vadr = polyObject->GetPolygonR();
+	if (polygonCount <= 0 || !padr || !vadr || !cornerNormals)
+		return false;
+
+	// Allocate triangle arrays for the worst case (all quads), they'll be shrunk later
+	const Int triangleCapacity = (Int)polygonCount * 2;
+	iferr (_p0.Resize(triangleCapacity))
+		return false;
+	iferr (_p1.Resize(triangleCapacity))
+		return false;
+	iferr (_p2.Resize(triangleCapacity))
+		return false;
+	iferr (_n0.Resize(triangleCapacity))
+		return false;
+	iferr (_n1.Resize(triangleCapacity))
+		return false;
+	iferr (_n2.Resize(triangleCapacity))
+		return false;
+	iferr (_polygonIndex.Resize(triangleCapacity))
+		return false;
+
+	// Triangulate polygons, skipping degenerated triangles.
+	// Parts number their polygons consecutively, skipping those without triangles, so no polygon index is larger than the triangle count.
+	Int triangleCount = 0;
+	Int32 partPolygonCount = 0;
+	for (Int32 k = 0; k < polygonCount; ++k)
+	{
+		if (thread && !(k & 4095) && thread->TestBreak())
+			return false;
+
+		const Int32 i = polygons ? polygons[k] : k;
+		const CPolygon &poly = vadr[i];
+		const Vector32 *polygonNormals = cornerNormals + (Int)i * 4;
+		const Int32 corners[2][3] = { { poly.a, poly.b, poly.c }, { poly.a, poly.c, poly.d } };
+		const Int32 cornerIndices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+		const Int32 triangles = (poly.c != poly.d) ? 2 : 1;
+		const Int32 polygonIndex = polygons ? partPolygonCount : k;
+		const Int firstTriangle = triangleCount;
+
+		for (Int32 t = 0; t < triangles; ++t)
+		{
+			const Vector &a = padr[corners[t][0]];
+			const Vector &b = padr[corners[t][1]];
+			const Vector &c = padr[corners[t][2]];
+			if (Cross(b - a, c - a).GetSquaredLength() == 0.0)
+				continue;
+
+			_p0[triangleCount] = a;
+			_p1[triangleCount] = b;
+			_p2[triangleCount] = c;
+			_n0[triangleCount] = polygonNormals[cornerIndices[t][0]];
+			_n1[triangleCount] = polygonNormals[cornerIndices[t][1]];
+			_n2[triangleCount] = polygonNormals[cornerIndices[t][2]];
+			_polygonIndex[triangleCount] = polygonIndex;
+			++triangleCount;
+		}
+		if (triangleCount > firstTriangle)
+			++partPolygonCount;
+	}
+
+	if (triangleCount == 0)
+		return false;
+
+	iferr (_p0.Resize(triangleCount))
+		return false;
+	iferr (_p1.Resize(triangleCount))
+		return false;
+	iferr (_p2.Resize(triangleCount))
+		return false;
+	iferr (_n0.Resize(triangleCount))
+		return false;
+	iferr (_n1.Resize(triangleCount))
+		return false;
+	iferr (_n2.Resize(triangleCount))
+		return false;
+	iferr (_polygonIndex.Resize(triangleCount))
+		return false;
+
+	// Without hierarchy, the triangles stay in polygon order
+	if (withHierarchy && !BuildHierarchy(thread))
+		return false;
+	return BuildPolygonLookup();
+}
+
+Bool wsCollisionMesh::BuildHierarchy(BaseThread *thread)
+{
+	/// A node that still needs to be built
+	struct BuildTask
+	{
+		Int32 _node;
+		Int32 _start;
+		Int32 _count;
+		Int32 _depth;
+	};
+
+	/// Bounds and triangle count of a split candidate bin
+	struct Bin
+	{
+		Vector _min;
+		Vector _max;
+		Int32  _count;
+	};
+
+	const Int32 triangleCount = GetTriangleCount();
+
+	// Precalculate triangle centroids, and the order in which the triangles will end up in the leaves
+	maxon::BaseArray<Vector> centroids;
+	maxon::BaseArray<Int32> order;
+	iferr (centroids.Resize(triangleCount))
+		return false;
+	iferr (order.Resize(triangleCount))
+		return false;
+	for (Int32 i = 0; i < triangleCount; ++i)
+	{
+		centroids[i] = (_p0[i] + _p1[i] + _p2[i]) / 3.0;
+		order[i] = i;
+	}
+
+	// Reserve memory for the worst case, a tree with one triangle per leaf
+	iferr (_nodes.EnsureCapacity((Int)triangleCount * 2))
+		return false;
+	iferr (_nodes.Append())
+		return false;
+
+	maxon::BaseArray<BuildTask> tasks;
+	iferr (tasks.Append(BuildTask{ 0, 0, triangleCount, 0 }))
+		return false;
+
+	const Float maxValue = maxon::LIMIT<Float>::MAX;
+	const Float minValue = maxon::LIMIT<Float>::MIN;
+	Int32 processedNodes = 0;
+
+	BuildTask task;
+	while (tasks.Pop(&task))
+	{
+		if (thread && !(++processedNodes & 1023) && thread->TestBreak())
+			return false;
+
+		// Compute bounds of triangles, and bounds of their centroids
+		Vector boxMin(maxValue), boxMax(minValue);
+		Vector centroidMin(maxValue), centroidMax(minValue);
+		for (Int32 i = task._start; i < task._start + task._count; ++i)
+		{
+			const Int32 t = order[i];
+			boxMin = VectorMin(boxMin, VectorMin(_p0[t], VectorMin(_p1[t], _p2[t])));
+			boxMax = VectorMax(boxMax, VectorMax(_p0[t], VectorMax(_p1[t], _p2[t])));
+			centroidMin = VectorMin(centroidMin, centroids[t]);
+			centroidMax = VectorMax(centroidMax, centroids[t]);
+		}
+
+		Node &node = _nodes[task._node];
+		node._min = boxMin;
+		node._max = boxMax;
+		node._start = task._start;
+		node._count = task._count;
+
+		if (task._count <= 2 || task._depth >= BVH_MAX_DEPTH)
+			continue;
+
+		// Split along the axis with the largest centroid extent
+		const Vector centroidSize = centroidMax - centroidMin;
+		Int32 axis = 0;
+		if (centroidSize.y > centroidSize[axis])
+			axis = 1;
+		if (centroidSize.z > centroidSize[axis])
+			axis = 2;
+
+		// All centroids in the same spot, can't be split spatially
+		if (centroidSize[axis] <= 0.0)
+		{
+			if (task._count <= BVH_MAX_LEAF_SIZE)
+				continue;
+		}
+
+		Int32 splitIndex = task._start + task._count / 2;
+
+		if (centroidSize[axis] > 0.0)
+		{
+			// Sort triangles into bins
+			Bin bins[BVH_BIN_COUNT];
+			for (Int32 b = 0; b < BVH_BIN_COUNT; ++b)
+			{
+				bins[b]._min = Vector(maxValue);
+				bins[b]._max = Vector(minValue);
+				bins[b]._count = 0;
+			}
+
+			const Float binScale = (Float)BVH_BIN_COUNT / centroidSize[axis];
+			for (Int32 i = task._start; i < task._start + task._count; ++i)
+			{
+				const Int32 t = order[i];
+				const Int32 b = ClampValue((Int32)((centroids[t][axis] - centroidMin[axis]) * binScale), 0, BVH_BIN_COUNT - 1);
+				bins[b]._min = VectorMin(bins[b]._min, VectorMin(_p0[t], VectorMin(_p1[t], _p2[t])));
+				bins[b]._max = VectorMax(bins[b]._max, VectorMax(_p0[t], VectorMax(_p1[t], _p2[t])));
+				++bins[b]._count;
+			}
+
+			// Sweep from the right to get the cost of all right hand sides
+			Float rightCost[BVH_BIN_COUNT];
+			Vector rightMin(maxValue), rightMax(minValue);
+			Int32 rightCount = 0;
+			for (Int32 b = BVH_BIN_COUNT - 1; b > 0; --b)
+			{
+				rightMin = VectorMin(rightMin, bins[b]._min);
+				rightMax = VectorMax(rightMax, bins[b]._max);
+				rightCount += bins[b]._count;
+				rightCost[b] = rightCount > 0 ? rightCount * GetBoxArea(rightMin, rightMax) : 0.0;
+			}
+
+			// Sweep from the left, and find the cheapest split (surface area heuristic)
+			Float bestCost = maxValue;
+			Int32 bestSplit = NOTOK;
+			Vector leftMin(maxValue), leftMax(minValue);
+			Int32 leftCount = 0;
+			for (Int32 b = 0; b < BVH_BIN_COUNT - 1; ++b)
+			{
+				leftMin = VectorMin(leftMin, bins[b]._min);
+				leftMax = VectorMax(leftMax, bins[b]._max);
+				leftCount += bins[b]._count;
+				if (leftCount == 0 || leftCount == task._count)
+					continue;
+
+				const Float cost = leftCount * GetBoxArea(leftMin, leftMax) + rightCost[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = b;
+				}
+			}
+
+			// Make a leaf if splitting doesn't pay off
+			if (task._count <= BVH_MAX_LEAF_SIZE && (bestSplit == NOTOK || bestCost >= task._count * GetBoxArea(boxMin, boxMax)))
+				continue;
+
+			if (bestSplit != NOTOK)
+			{
+				// Partition triangles, the ones in bins up to bestSplit go to the left
+				Int32 left = task._start;
+				Int32 right = task._start + task._count - 1;
+				while (left <= right)
+				{
+					const Int32 b = ClampValue((Int32)((centroids[order[left]][axis] - centroidMin[axis]) * binScale), 0, BVH_BIN_COUNT - 1);
+					if (b <= bestSplit)
+					{
+						++left;
+					}
+					else
+					{
+						const Int32 tmp = order[left];
+						order[left] = order[right];
+						order[right] = tmp;
+						--right;
+					}
+				}
+				splitIndex = left;
+			}
+		}
+
+		// Create children. Careful, appending might invalidate the node reference.
+		const Int32 firstChild = (Int32)_nodes.GetCount();
+		iferr (_nodes.Append())
+			return false;
+		iferr (_nodes.Append())
+			return false;
+		_nodes[task._node]._start = firstChild;
+		_nodes[task._node]._count = 0;
+
+		const Int32 leftCount = splitIndex - task._start;
+		iferr (tasks.Append(BuildTask{ firstChild, task._start, leftCount, task._depth + 1 }))
+			return false;
+		iferr (tasks.Append(BuildTask{ firstChild + 1, splitIndex, task._count - leftCount, task._depth + 1 }))
+			return false;
+	}
+
+	// Bring triangle data into leaf order, so each leaf references a contiguous range
+	if (!ReorderArray(_p0, order) || !ReorderArray(_p1, order) || !ReorderArray(_p2, order))
+		return false;
+	if (!ReorderArray(_n0, order) || !ReorderArray(_n1, order) || !ReorderArray(_n2, order))
+		return false;
+	if (!ReorderArray(_polygonIndex, order))
+		return false;
+
+	return true;
+}
+
+Bool wsCollisionMesh::BuildPolygonLookup()
+{
+	// Polygons are triangulated in order, so the highest index tells the polygon count (or at least the part that matters)
+	Int32 polyCount = 0;
+	for (Int32 i = 0; i < GetTriangleCount(); ++i)
+		polyCount = Max(polyCount, _polygonIndex[i] + 1);
+
+	iferr (_polygonTriangles.Resize((Int)polyCount * 2))
+		return false;
+	for (Int i = 0; i < _polygonTriangles.GetCount(); ++i)
+		_polygonTriangles[i] = NOTOK;
+
+	for (Int32 i = 0; i < GetTriangleCount(); ++i)
+	{
+		const Int slot = (Int)_polygonIndex[i] * 2;
+		if (_polygonTriangles[slot] == NOTOK)
+			_polygonTriangles[slot] = i;
+		else
+			_polygonTriangles[slot + 1] = i;
+	}
+
+	return true;
+}
+
+void wsCollisionMesh::Reset()
+{
+	_p0.Reset();
+	_p1.Reset();
+	_p2.Reset();
+	_n0.Reset();
+	_n1.Reset();
+	_n2.Reset();
+	_polygonIndex.Reset();
+	_polygonTriangles.Reset();
+	_nodes.Reset();
+	_fingerprint = 0;
+	_source = nullptr;
+	_dirtyness = 0;
+	_initialized = false;
+}
+
+Bool wsCollisionMesh::GetBoundingBox(Vector &boxMin, Vector &boxMax) const
+{
+	if (!_initialized || _nodes.IsEmpty())
+		return false;
+
+	boxMin = _nodes[0]._min;
+	boxMax = _nodes[0]._max;
+	return true;
+}
+
+Bool wsCollisionMesh::GetClosestPoint(const Vector &position, Float maxDistance, wsCollisionMeshHit &hit) const
+{
+	if (!_initialized || _nodes.IsEmpty())
+		return false;
+
+	// Everything further away than the best hit so far (or the maximum search radius) can be skipped
+	Float bestDistanceSquared = maxDistance > 0.0 ? maxDistance * maxDistance : maxon::LIMIT<Float>::MAX;
+	Int32 bestTriangle = NOTOK;
+	Float bestU = 0.0;
+	Float bestV = 0.0;
+	Vector bestPosition;
+
+	Int32 stack[BVH_MAX_DEPTH + 2];
+	Int32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node &node = _nodes[stack[--stackSize]];
+
+		// The search radius might have shrunk since this node was pushed
+		if (DistanceSquaredToBox(position, node._min, node._max) >= bestDistanceSquared)
+			continue;
+
+		if (node._count > 0)
+		{
+			for (Int32 t = node._start; t < node._start + node._count; ++t)
+			{
+				Float u, v;
+				const Vector closest = ClosestPointOnTriangle(position, _p0[t], _p1[t], _p2[t], u, v);
+				const Float distanceSquared = (closest - position).GetSquaredLength();
+				if (distanceSquared < bestDistanceSquared)
+				{
+					bestDistanceSquared = distanceSquared;
+					bestTriangle = t;
+					bestU = u;
+					bestV = v;
+					bestPosition = closest;
+				}
+			}
+			continue;
+		}
+
+		// Push the closer child last, so it is visited first and the search radius shrinks as quickly as possible
+		Int32 nearChild = node._start;
+		Int32 farChild = node._start + 1;
+		Float nearDistance = DistanceSquaredToBox(position, _nodes[nearChild]._min, _nodes[nearChild]._max);
+		Float farDistance = DistanceSquaredToBox(position, _nodes[farChild]._min, _nodes[farChild]._max);
+		if (farDistance < nearDistance)
+		{
+			nearChild = node._start + 1;
+			farChild = node._start;
+			const Float tmp = nearDistance;
+			nearDistance = farDistance;
+			farDistance = tmp;
+		}
+		if (farDistance < bestDistanceSquared)
+			stack[stackSize++] = farChild;
+		if (nearDistance < bestDistanceSquared)
+			stack[stackSize++] = nearChild;
+	}
+
+	if (bestTriangle == NOTOK)
+		return false;
+
+	hit._triangle = bestTriangle;
+	hit._distance = Sqrt(bestDistanceSquared);
+	hit._u = bestU;
+	hit._v = bestV;
+	hit._position = bestPosition;
+	return true;
+}
+
+Bool wsCollisionMesh::IntersectLine(const Vector &origin, const Vector &direction, Float maxDistance, Bool preferForward, wsCollisionMeshHit &hit) const
+{
+	if (!_initialized || _nodes.IsEmpty() || maxDistance <= 0.0)
+		return false;
+
+	const Float directionLength = direction.GetLength();
+	if (directionLength == 0.0)
+		return false;
+
+	const Vector rayDirection = direction / directionLength;
+
+	// Division by zero gives infinity, the box test skips those axes
+	const Vector inverseDirection(1.0 / rayDirection.x, 1.0 / rayDirection.y, 1.0 / rayDirection.z);
+
+	// Nearest hits found so far, in front of and behind the origin
+	Float forward = maxDistance;
+	Float backward = maxDistance;
+
+	// Everything outside of (-backwardLimit, forwardLimit) can be skipped
+	Float forwardLimit = maxDistance;
+	Float backwardLimit = maxDistance;
+	Int32 forwardTriangle = NOTOK;
+	Int32 backwardTriangle = NOTOK;
+	Float forwardU = 0.0, forwardV = 0.0;
+	Float backwardU = 0.0, backwardV = 0.0;
+
+	Int32 stack[BVH_MAX_DEPTH + 2];
+	Int32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node &node = _nodes[stack[--stackSize]];
+
+		// The interval might have shrunk since this node was pushed
+		Float tNear, tFar;
+		if (!IntersectBox(origin, rayDirection, inverseDirection, node._min, node._max, tNear, tFar) || tNear >= forwardLimit || tFar <= -backwardLimit)
+			continue;
+
+		if (node._count > 0)
+		{
+			for (Int32 t = node._start; t < node._start + node._count; ++t)
+			{
+				Float distance, u, v;
+				if (!IntersectTriangle(origin, rayDirection, _p0[t], _p1[t], _p2[t], distance, u, v))
+					continue;
+
+				if (distance >= 0.0)
+				{
+					if (distance < forward)
+					{
+						forward = distance;
+						forwardTriangle = t;
+						forwardU = u;
+						forwardV = v;
+					}
+				}
+				else if (-distance < backward)
+				{
+					backward = -distance;
+					backwardTriangle = t;
+					backwardU = u;
+					backwardV = v;
+				}
+			}
+
+			// Shrink the interval. When preferring forward hits, the backward side doesn't matter anymore once there is a forward hit.
+			// Otherwise, each side only matters as long as it can beat the best hit on the other side.
+			forwardLimit = forward;
+			backwardLimit = backward;
+			if (preferForward)
+			{
+				if (forwardTriangle != NOTOK)
+					backwardLimit = 0.0;
+			}
+			else
+			{
+				forwardLimit = Min(forward, backward);
+				backwardLimit = forwardLimit;
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node._start + 1;
+		stack[stackSize++] = node._start;
+	}
+
+	// Pick the winner
+	Bool useForward = forwardTriangle != NOTOK;
+	if (useForward && backwardTriangle != NOTOK && !preferForward)
+		useForward = forward <= backward;
+	if (!useForward && backwardTriangle == NOTOK)
+		return false;
+
+	hit._triangle = useForward ? forwardTriangle : backwardTriangle;
+	hit._distance = useForward ? forward : -backward;
+	hit._u = useForward ? forwardU : backwardU;
+	hit._v = useForward ? forwardV : backwardV;
+	hit._position = origin + rayDirection * hit._distance;
+	return true;
+}
+
+Vector wsCollisionMesh::GetInterpolatedNormal(const wsCollisionMeshHit &hit) const
+{
+	if (hit._triangle < 0 || hit._triangle >= GetTriangleCount())
+		return Vector(0.0, 1.0, 0.0);
+
+	const Int32 t = hit._triangle;
+	const Vector normal = Vector(_n0[t]) * (1.0 - hit._u - hit._v) + Vector(_n1[t]) * hit._u + Vector(_n2[t]) * hit._v;
+
+	// Vertex normals might cancel each other out, fall back to the face normal
+	if (normal.GetSquaredLength() == 0.0)
+		return Cross(_p1[t] - _p0[t], _p2[t] - _p0[t]).GetNormalized();
+
+	return normal.GetNormalized();
+}
+
+Bool wsCollisionMesh::GetInterpolatedNormal(Int32 polygonIndex, const Vector &position, Vector &normal) const
+{
+	if (polygonIndex < 0 || (Int)polygonIndex * 2 >= _polygonTriangles.GetCount())
+		return false;
+
+	// A quad has two triangles, use the one the position is closest to
+	wsCollisionMeshHit hit;
+	Float bestDistanceSquared = maxon::LIMIT<Float>::MAX;
+	for (Int32 k = 0; k < 2; ++k)
+	{
+		const Int32 t = _polygonTriangles[(Int)polygonIndex * 2 + k];
+		if (t == NOTOK)
+			continue;
+
+		Float u, v;
+		const Float distanceSquared = (ClosestPointOnTriangle(position, _p0[t], _p1[t], _p2[t], u, v) - position).GetSquaredLength();
+		if (distanceSquared < bestDistanceSquared)
+		{
+			bestDistanceSquared = distanceSquared;
+			hit._triangle = t;
+			hit._u = u;
+			hit._v = v;
+		}
+	}
+
+	if (hit._triangle == NOTOK)
+		return false;
+
+	normal = GetInterpolatedNormal(hit);
+	return true;
+}
+
+Int wsCollisionMesh::GetMemorySize() const
+{
+	const Int triangleSize = 3 * sizeof(Vector) + 3 * sizeof(Vector32) + sizeof(Int32);
+	return GetTriangleCount() * triangleSize + _polygonTriangles.GetCount() * sizeof(Int32) + _nodes.GetCount() * sizeof(Node);
+}
+
+Bool wsCollisionMesh::Write(BaseFile *file) const
+{
+	if (!file || !HasHierarchy())
+		return false;
+
+	const Int32 triangleCount = GetTriangleCount();
+	if (!file->WriteUInt64(_fingerprint))
+		return false;
+
+	// Triangles, already in leaf order
+	if (!WriteArrayToFile(file, _p0.GetFirst(), triangleCount) || !WriteArrayToFile(file, _p1.GetFirst(), triangleCount) || !WriteArrayToFile(file, _p2.GetFirst(), triangleCount))
+		return false;
+	if (!WriteArrayToFile(file, _n0.GetFirst(), triangleCount) || !WriteArrayToFile(file, _n1.GetFirst(), triangleCount) || !WriteArrayToFile(file, _n2.GetFirst(), triangleCount))
+		return false;
+	if (!WriteArrayToFile(file, _polygonIndex.GetFirst(), triangleCount))
+		return false;
+
+	// Hierarchy
+	return WriteArrayToFile(file, _nodes.GetFirst(), (Int32)_nodes.GetCount());
+}
+
+Bool wsCollisionMesh::ValidateHierarchy() const
+{
+	const Int32 nodeCount = (Int32)_nodes.GetCount();
+	const Int32 triangleCount = GetTriangleCount();
+	if (nodeCount == 0)
+		return false;
+
+	// Depth of each node, NOTOK while no inner node references it
+	maxon::BaseArray<Int32> depth;
+	iferr (depth.Resize(nodeCount))
+		return false;
+	for (Int32 i = 0; i < nodeCount; ++i)
+		depth[i] = NOTOK;
+	depth[0] = 0;
+
+	// Children are always stored after their parent, so each node's depth is known when it's visited
+	for (Int32 i = 0; i < nodeCount; ++i)
+	{
+		const Node &node = _nodes[i];
+		if (depth[i] == NOTOK || node._count < 0)
+			return false;
+
+		// Leaf
+		if (node._count > 0)
+		{
+			if (node._start < 0 || node._start > triangleCount - node._count)
+				return false;
+			continue;
+		}
+
+		// Inner node. Its children must not be deeper than BVH_MAX_DEPTH, or the traversal stack overflows.
+		if (node._start <= i || node._start > nodeCount - 2 || depth[i] >= BVH_MAX_DEPTH)
+			return false;
+		for (Int32 child = node._start; child < node._start + 2; ++child)
+		{
+			if (depth[child] != NOTOK)
+				return false;
+			depth[child] = depth[i] + 1;
+		}
+	}
+
+	// Polygon indices are used to size and index the lookup table. Parts number their polygons consecutively, so there are never more polygons than triangles.
+	for (const Int32 polygonIndex : _polygonIndex)
+	{
+		if (polygonIndex < 0 || polygonIndex >= triangleCount)
+			return false;
+	}
+
+	return true;
+}
+
+Bool wsCollisionMesh::Read(BaseFile *file)
+{
+	Reset();
+	if (!file)
+		return false;
+
+	UInt64 fingerprint = 0;
+	if (!file->ReadUInt64(&fingerprint))
+		return false;
+
+	// Triangles, all arrays must have the same size
+	Bool success = ReadArrayFromFile(file, _p0);
+	const Int32 triangleCount = GetTriangleCount();
+	success = success && ReadArrayFromFile(file, _p1, triangleCount) && ReadArrayFromFile(file, _p2, triangleCount);
+	success = success && ReadArrayFromFile(file, _n0, triangleCount) && ReadArrayFromFile(file, _n1, triangleCount) && ReadArrayFromFile(file, _n2, triangleCount);
+	success = success && ReadArrayFromFile(file, _polygonIndex, triangleCount);
+
+	// Hierarchy. It comes from a file, so it's checked before anything traverses it.
+	success = success && ReadArrayFromFile(file, _nodes) && ValidateHierarchy();
+	success = success && BuildPolygonLookup();
+	if (!success || triangleCount == 0)
+	{
+		Reset();
+		return false;
+	}
+
+	_fingerprint = fingerprint;
+	_initialized = true;
+	return true;
+}
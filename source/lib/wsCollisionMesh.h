@@ -0,0 +1,171 @@
+#ifndef WS_COLLISIONMESH_H__
+#define WS_COLLISIONMESH_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+
+
+/// Result of a query on a wsCollisionMesh
+struct wsCollisionMeshHit
+{
+	Int32  _triangle = NOTOK;  ///< Index of the triangle that was found
+	Float  _distance = 0.0_f;  ///< Distance between query position and hit position
+	Float  _u = 0.0_f;         ///< Barycentric weight of the triangle's second corner
+	Float  _v = 0.0_f;         ///< Barycentric weight of the triangle's third corner
+	Vector _position;          ///< Hit position (in the local space of the mesh)
+};
+
+
+/// Triangulated copy of a PolygonObject, with a bounding volume hierarchy (BVH) on top.
+/// Supports queries the GeRayCollider doesn't offer, like finding the closest point on the surface.
+/// @note All positions are in the local space of the PolygonObject the mesh was built from.
+class wsCollisionMesh
+{
+private:
+	/// A node of the BVH. Inner nodes have _count == 0 and their children at _start and _start + 1. Leaf nodes reference the triangles [_start, _start + _count).
+	struct Node
+	{
+		Vector _min;    ///< Minimum of bounding box
+		Vector _max;    ///< Maximum of bounding box
+		Int32  _start;  ///< Index of first child (inner node) or first triangle (leaf)
+		Int32  _count;  ///< Number of triangles (leaf), or 0 (inner node)
+	};
+
+	maxon::BaseArray<Vector>    _p0;                ///< First corner of each triangle
+	maxon::BaseArray<Vector>    _p1;                ///< Second corner of each triangle
+	maxon::BaseArray<Vector>    _p2;                ///< Third corner of each triangle
+	maxon::BaseArray<Vector32>  _n0;                ///< Vertex normal at the first corner of each triangle
+	maxon::BaseArray<Vector32>  _n1;                ///< Vertex normal at the second corner of each triangle
+	maxon::BaseArray<Vector32>  _n2;                ///< Vertex normal at the third corner of each triangle
+	maxon::BaseArray<Int32>     _polygonIndex;      ///< Index of the polygon each triangle was created from
+	maxon::BaseArray<Int32>     _polygonTriangles;  ///< Two entries per polygon: Indices of the triangles created from it, or NOTOK
+	maxon::BaseArray<Node>      _nodes;             ///< BVH nodes, the root is _nodes[0]
+	UInt64                      _fingerprint;       ///< Hash of the geometry the mesh was built from
+	const PolygonObject        *_source;            ///< The object the mesh was built from. Only compared, never dereferenced.
+	UInt64                      _dirtyness;         ///< Dirty state of _source (and its phong and normal tags) when the mesh was built
+	Bool                        _initialized;       ///< Indicates if the mesh has been built
+
+	/// Triangulate polygons, and build the hierarchy over the triangles
+	/// @param polygons Indices of the polygons to use, or nullptr to use the first polygonCount polygons
+	/// @param cornerNormals Four normals per polygon of polyObject, as returned by GetCornerNormals()
+	/// @param withHierarchy If false, only triangles and vertex normals are built
+	Bool Build(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, const Vector32 *cornerNormals, Bool withHierarchy, BaseThread *thread);
+
+	/// Build the BVH over the triangles, and reorder the triangle arrays accordingly
+	Bool BuildHierarchy(BaseThread *thread);
+
+	/// Fill _polygonTriangles from _polygonIndex. Must be called after the triangles have been reordered.
+	Bool BuildPolygonLookup();
+
+	/// Check that the hierarchy can be traversed safely: Leaves reference existing triangles, each node except the root is the child of exactly one inner node that comes before it, and no node is deeper than the traversal stack allows.
+	/// Also checks that the polygon indices are smaller than the triangle count, so the polygon lookup can't grow larger than the mesh.
+	/// @return False if the hierarchy or the polygon indices are damaged, otherwise true
+	Bool ValidateHierarchy() const;
+
+public:
+	/// Build mesh and hierarchy from a PolygonObject
+	/// @note Like GeRayCollider::Init(), this does nothing if the geometry didn't change since the last call. If the same object is passed again and its dirty counts didn't change, the geometry isn't even hashed.
+	/// @param polyObject The geometry to build from. Caller owns the pointed object.
+	/// @param force Force rebuilding, even if the geometry did not change
+	/// @param withHierarchy If false, only triangles and vertex normals are built. That's enough for GetInterpolatedNormal(), but not for the queries. A hierarchy that has been built before is kept.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return True if building was successful, otherwise false
+	Bool Init(const PolygonObject *polyObject, Bool force = false, Bool withHierarchy = true, BaseThread *thread = nullptr);
+
+	/// Build mesh and hierarchy from a part of a PolygonObject, e.g. a tile of a larger geometry
+	/// @note The polygon indices used by GetInterpolatedNormal() number the polygons that produced triangles consecutively, in the order of the polygons array. Polygons without triangles are skipped.
+	/// @param polyObject The geometry. Caller owns the pointed object.
+	/// @param polygons Indices of the polygons that belong to the part
+	/// @param polygonCount Number of entries in polygons
+	/// @param cornerNormals Vertex normals of the whole geometry, as returned by GetCornerNormals(). Computing them once for the whole geometry keeps them continuous across the borders of the parts.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return True if building was successful, otherwise false
+	Bool InitPart(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, const Vector32 *cornerNormals, BaseThread *thread = nullptr);
+
+	/// Compute the shading normal at each polygon corner. Respects phong angle and normal tags if there is a phong tag, otherwise area weighted face normals are averaged at each point.
+	/// @param polyObject The geometry. Caller owns the pointed object.
+	/// @param cornerNormals Receives four normalized normals per polygon
+	/// @return False if the object has no polygons or memory ran out, otherwise true
+	static Bool GetCornerNormals(const PolygonObject *polyObject, maxon::BaseArray<Vector32> &cornerNormals);
+
+	/// Free all data
+	void Reset();
+
+	/// @return True if the mesh has been built successfully
+	Bool IsInitialized() const
+	{
+		return _initialized;
+	}
+
+	/// @return True if the mesh has been built with its hierarchy, so it can be queried
+	Bool HasHierarchy() const
+	{
+		return _initialized && !_nodes.IsEmpty();
+	}
+
+	/// @return Number of triangles in the mesh
+	Int32 GetTriangleCount() const
+	{
+		return (Int32)_p0.GetCount();
+	}
+
+	/// @return Hash of the geometry the mesh was built from. Can be used by other caches to find out if they need to be rebuilt.
+	UInt64 GetFingerprint() const
+	{
+		return _fingerprint;
+	}
+
+	/// Get the bounding box of the mesh
+	/// @param boxMin Receives the minimum of the bounding box
+	/// @param boxMax Receives the maximum of the bounding box
+	/// @return False if the mesh has not been built, otherwise true
+	Bool GetBoundingBox(Vector &boxMin, Vector &boxMax) const;
+
+	/// Find the closest point on the mesh surface
+	/// @param position Query position
+	/// @param maxDistance Only points closer than this are found. Pass 0.0 for an unlimited search radius.
+	/// @param hit Receives the result
+	/// @return True if a point was found, otherwise false
+	Bool GetClosestPoint(const Vector &position, Float maxDistance, wsCollisionMeshHit &hit) const;
+
+	/// Find the nearest intersection of an infinite line with the mesh, looking in both directions from the origin in a single traversal
+	/// @param origin Origin of the line
+	/// @param direction Direction of the line, does not need to be normalized
+	/// @param maxDistance Only intersections within [-maxDistance, maxDistance] along the line are found
+	/// @param preferForward If true, an intersection in forward direction always wins, even if there is a closer one behind the origin. Otherwise, the closest one on either side wins.
+	/// @param hit Receives the result. hit._distance is the signed distance along the normalized direction.
+	/// @return True if an intersection was found, otherwise false
+	Bool IntersectLine(const Vector &origin, const Vector &direction, Float maxDistance, Bool preferForward, wsCollisionMeshHit &hit) const;
+
+	/// Get the normal at a hit position, interpolated from the vertex normals
+	/// @param hit A hit returned by one of the query functions
+	/// @return The normalized surface normal
+	Vector GetInterpolatedNormal(const wsCollisionMeshHit &hit) const;
+
+	/// Get the normal at a position on a polygon, interpolated from the vertex normals. Useful for hits found by other means, like a GeRayCollider.
+	/// @param polygonIndex Index of the polygon in the PolygonObject the mesh was built from
+	/// @param position Position on the polygon
+	/// @param normal Receives the normalized surface normal
+	/// @return False if the polygon has no triangles in the mesh, otherwise true
+	Bool GetInterpolatedNormal(Int32 polygonIndex, const Vector &position, Vector &normal) const;
+
+	/// @return Approximate number of bytes used by triangles and hierarchy
+	Int GetMemorySize() const;
+
+	/// Write triangles and hierarchy to a file, so the mesh can be loaded later without building it again
+	/// @param file An open file
+	/// @return False if the mesh has not been built with hierarchy or writing failed, otherwise true
+	Bool Write(BaseFile *file) const;
+
+	/// Read triangles and hierarchy written by Write()
+	/// @param file An open file, positioned at the start of the data written by Write()
+	/// @return False if reading failed, otherwise true
+	Bool Read(BaseFile *file);
+
+	/// Default constructor
+	wsCollisionMesh() : _fingerprint(0), _source(nullptr), _dirtyness(0), _initialized(false)
+	{ }
+};
+
+#endif // WS_COLLISIONMESH_H__
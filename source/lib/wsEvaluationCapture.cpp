@@ -0,0 +1,221 @@
+#include "maxon/apibase.h"
+#include "wsEvaluationCapture.h"
+#include "wsFunctions.h"
+
+
+static const Int32 CAPTURE_MAGIC = 0x43505357;  ///< "WSPC", identifies capture files
+static const Int32 CAPTURE_VERSION = 1;          ///< Increase when the file layout changes
+
+
+Bool WriteEvaluationCapture(const Filename &filename, PointObject *op, const Vector *inputPoints, const wsPointProjectorParams &params, const Float *falloffValues, const PolygonObject *collisionGeometry, const Matrix &collisionObjectMg)
+{
+	if (!op || !inputPoints || !collisionGeometry || (params.HasFalloff() && !falloffValues))
+		return false;
+
+	AutoAlloc<BaseFile> file;
+	if (!file || !file->Open(filename, FILEOPEN::WRITE, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+		return false;
+
+	const Int32 pointCount = op->GetPointCount();
+	const Matrix opMg = op->GetMg();
+
+	// Header
+	file->WriteInt32(CAPTURE_MAGIC);
+	file->WriteInt32(CAPTURE_VERSION);
+
+	// Parameters and matrices
+	file->WriteInt32((Int32)params._mode);
+	file->WriteInt32((Int32)params._direction);
+	file->WriteFloat64(params._offset);
+	file->WriteFloat64(params._blend);
+	file->WriteBool(params._geometryFalloffEnabled);
+	file->WriteFloat64(params._geometryFalloffDist);
+	file->WriteFloat64(params._maxSearchDist);
+	file->WriteInt32(params._sdfResolution);
+	file->WriteMatrix64(params._modifierMg);
+	file->WriteMatrix64(opMg);
+	file->WriteMatrix64(collisionObjectMg);
+
+	// Points before and after projection
+	WriteArrayToFile(file, inputPoints, pointCount);
+	WriteArrayToFile(file, op->GetPointR(), pointCount);
+
+	// Collision geometry
+	WriteArrayToFile(file, collisionGeometry->GetPointR(), collisionGeometry->GetPointCount());
+	WriteArrayToFile(file, collisionGeometry->GetPolygonR(), collisionGeometry->GetPolygonCount());
+
+	// Weight map
+	file->WriteBool(params._weightMap != nullptr);
+	if (params._weightMap)
+		WriteArrayToFile(file, params._weightMap, pointCount);
+
+	// Falloff values, as sampled by the projection at the input points
+	file->WriteBool(params.HasFalloff());
+	if (params.HasFalloff())
+		WriteArrayToFile(file, falloffValues, pointCount);
+
+	// BaseFile remembers write errors, Close() reports them
+	return file->Close();
+}
+
+Bool ReplayEvaluationCapture(const Filename &filename, Int32 repeat, wsTiledCollisionMesh *tiles, Bool generic)
+{
+	AutoAlloc<BaseFile> file;
+	if (!file || !file->Open(filename, FILEOPEN::READ, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+	{
+		GePrint("PointProjector: Could not open capture file "_s + filename.GetString());
+		return false;
+	}
+
+	// Header
+	Int32 magic = 0;
+	Int32 version = 0;
+	if (!file->ReadInt32(&magic) || !file->ReadInt32(&version) || magic != CAPTURE_MAGIC || version != CAPTURE_VERSION)
+	{
+		GePrint("PointProjector: Not a capture file, or unsupported version: "_s + filename.GetString());
+		return false;
+	}
+
+	// Parameters and matrices
+	Int32 mode = 0;
+	Int32 direction = 0;
+	Float64 offset = 0.0, blend = 0.0, geometryFalloffDist = 0.0, maxSearchDist = 0.0;
+	Bool geometryFalloffEnabled = false;
+	Int32 sdfResolution = 0;
+	Matrix64 modifierMg, opMg, collisionObjectMg;
+	file->ReadInt32(&mode);
+	file->ReadInt32(&direction);
+	file->ReadFloat64(&offset);
+	file->ReadFloat64(&blend);
+	file->ReadBool(&geometryFalloffEnabled);
+	file->ReadFloat64(&geometryFalloffDist);
+	file->ReadFloat64(&maxSearchDist);
+	file->ReadInt32(&sdfResolution);
+	file->ReadMatrix64(&modifierMg);
+	file->ReadMatrix64(&opMg);
+	file->ReadMatrix64(&collisionObjectMg);
+
+	// Points, collision geometry, weight map and falloff values
+	maxon::BaseArray<Vector> inputPoints, capturedPoints, collisionPoints;
+	maxon::BaseArray<CPolygon> collisionPolygons;
+	maxon::BaseArray<Float32> weightMap;
+	maxon::BaseArray<Float64> falloffValues;
+	Bool hasWeightMap = false;
+	Bool hasFalloff = false;
+	Bool success = ReadArrayFromFile(file, inputPoints);
+	success = success && ReadArrayFromFile(file, capturedPoints, (Int32)inputPoints.GetCount());
+	if (tiles)
+	{
+		// The tiles replace the captured collision geometry, it's not even loaded
+		success = success && SkipArrayInFile<Vector>(file) && SkipArrayInFile<CPolygon>(file);
+	}
+	else
+	{
+		success = success && ReadArrayFromFile(file, collisionPoints);
+		success = success && ReadArrayFromFile(file, collisionPolygons);
+	}
+	success = success && file->ReadBool(&hasWeightMap) && (!hasWeightMap || ReadArrayFromFile(file, weightMap, (Int32)inputPoints.GetCount()));
+	success = success && file->ReadBool(&hasFalloff) && (!hasFalloff || ReadArrayFromFile(file, falloffValues, (Int32)inputPoints.GetCount()));
+	if (!success || file->GetError() != FILEERROR::NONE)
+	{
+		GePrint("PointProjector: Capture file is damaged: "_s + filename.GetString());
+		return false;
+	}
+	file->Close();
+
+	// Rebuild collision geometry. With tiles, it stays empty.
+	const Int32 pointCount = (Int32)inputPoints.GetCount();
+	AutoAlloc<PolygonObject> collisionGeometry((Int32)collisionPoints.GetCount(), (Int32)collisionPolygons.GetCount());
+	AutoAlloc<PolygonObject> op(pointCount, 0);
+	if (!collisionGeometry || !op)
+		return false;
+	op->SetMg(opMg);
+
+	wsPointProjector projector;
+	if (!tiles)
+	{
+		CopyMem(collisionPoints.GetFirst(), collisionGeometry->GetPointW(), collisionPoints.GetCount() * sizeof(Vector));
+		CopyMem(collisionPolygons.GetFirst(), collisionGeometry->GetPolygonW(), collisionPolygons.GetCount() * sizeof(CPolygon));
+		collisionGeometry->SetMg(collisionObjectMg);
+		collisionGeometry->Message(MSG_UPDATE);
+
+		if (!projector.Init(collisionGeometry, true))
+		{
+			GePrint("PointProjector: Could not initialize projector"_s);
+			return false;
+		}
+	}
+
+	wsPointProjectorParams params(modifierMg, (PROJECTORMODE)mode, (PROJECTORDIRECTION)direction, offset, blend, geometryFalloffEnabled, geometryFalloffDist, maxSearchDist, sdfResolution, hasWeightMap ? weightMap.GetFirst() : nullptr, nullptr);
+	params._falloffValues = hasFalloff ? falloffValues.GetFirst() : nullptr;
+
+	// The first run also builds the collision caches the mode needs, so it's reported separately
+	Float64 firstTime = 0.0;
+	Float64 minTime = maxon::LIMIT<Float64>::MAX;
+	Float64 totalTime = 0.0;
+	repeat = Max(repeat, (Int32)1);
+	for (Int32 run = 0; run <= repeat; ++run)
+	{
+		CopyMem(inputPoints.GetFirst(), op->GetPointW(), pointCount * sizeof(Vector));
+		op->Message(MSG_UPDATE);
+
+		const Float64 startTime = GeGetMilliSeconds();
+		Bool success;
+		if (tiles)
+		{
+			// Tiles work in global space
+			Vector *padr = op->GetPointW();
+			const Matrix opMgI = ~Matrix(opMg);
+			for (Int32 i = 0; i < pointCount; ++i)
+				padr[i] = opMg * padr[i];
+			success = tiles->Project(padr, pointCount, params);
+			for (Int32 i = 0; i < pointCount; ++i)
+				padr[i] = opMgI * padr[i];
+		}
+		else if (generic)
+		{
+			success = projector.ProjectGeneric(op, params);
+		}
+		else
+		{
+			success = projector.Project(op, params);
+		}
+		if (!success)
+		{
+			GePrint("PointProjector: Projection failed"_s);
+			return false;
+		}
+		const Float64 time = GeGetMilliSeconds() - startTime;
+
+		if (run == 0)
+		{
+			firstTime = time;
+		}
+		else
+		{
+			minTime = Min(minTime, time);
+			totalTime += time;
+		}
+	}
+
+	// Compare with the captured result
+	const Vector *padr = op->GetPointR();
+	Float maxDeviation = 0.0;
+	for (Int32 i = 0; i < pointCount; ++i)
+		maxDeviation = Max(maxDeviation, (padr[i] - capturedPoints[i]).GetLength());
+
+	GePrint("PointProjector: Replayed "_s + filename.GetString());
+	GePrint("  Implementation: "_s + (tiles ? "tiles"_s : (generic ? "generic loop"_s : "specialized kernels"_s)));
+	if (tiles)
+		GePrint("  Points: "_s + String::IntToString(pointCount));
+	else
+		GePrint("  Points: "_s + String::IntToString(pointCount) + ", collision polygons: "_s + String::IntToString((Int32)collisionPolygons.GetCount()));
+	GePrint("  First run (including cache build): "_s + String::FloatToString(firstTime) + " ms"_s);
+	GePrint("  Runs: "_s + String::IntToString(repeat) + ", min: "_s + String::FloatToString(minTime) + " ms, average: "_s + String::FloatToString(totalTime / repeat) + " ms"_s);
+	GePrint("  Max. deviation from capture: "_s + String::FloatToString(maxDeviation));
+	GePrint("  Result hash: "_s + String::UIntToString(HashMemory(padr, pointCount * sizeof(Vector))));
+	if (tiles)
+		GePrint("  Tiles: "_s + String::IntToString(tiles->GetTileCount()) + ", loaded: "_s + String::IntToString(tiles->GetLoadCount()) + ", peak memory: "_s + String::IntToString((Int32)(tiles->GetPeakMemory() >> 20)) + " MB"_s);
+
+	return true;
+}
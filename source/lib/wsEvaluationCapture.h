@@ -0,0 +1,30 @@
+#ifndef WS_EVALUATIONCAPTURE_H__
+#define WS_EVALUATIONCAPTURE_H__
+
+
+#include "c4d.h"
+#include "wsPointProjector.h"
+#include "wsTiledCollisionMesh.h"
+
+
+/// Write everything a projection needs to a binary file, so it can be replayed outside of the scene it happened in.
+/// The file contains the parameters, all matrices, the input points, the collision geometry, the weight map, the sampled falloff values, and the resulting points.
+/// @param filename The file to write
+/// @param op The projected PointObject, its points must already be projected
+/// @param inputPoints The points of op before projection (op's local space)
+/// @param params The parameters that have been used for projection
+/// @param falloffValues The falloff values the projection has sampled at the input points (see wsPointProjector::GetFalloffValues()), only used if params has a falloff
+/// @param collisionGeometry The polygon geometry the points have been projected on
+/// @param collisionObjectMg Global matrix of the collision geometry
+/// @return False if there was a problem, otherwise true
+Bool WriteEvaluationCapture(const Filename &filename, PointObject *op, const Vector *inputPoints, const wsPointProjectorParams &params, const Float *falloffValues, const PolygonObject *collisionGeometry, const Matrix &collisionObjectMg);
+
+/// Read a file written by WriteEvaluationCapture(), project the points again, and print timings and the deviation from the captured result
+/// @param filename The file to read
+/// @param repeat Number of times the projection is repeated
+/// @param tiles If set, the points are projected on these tiles instead of the captured collision geometry
+/// @param generic If true, wsPointProjector::ProjectGeneric() is used instead of the specialized kernels, as a baseline for comparison. Ignored when projecting on tiles.
+/// @return False if there was a problem, otherwise true
+Bool ReplayEvaluationCapture(const Filename &filename, Int32 repeat, wsTiledCollisionMesh *tiles = nullptr, Bool generic = false);
+
+#endif // WS_EVALUATIONCAPTURE_H__
@@ -142,6 +142,126 @@ UInt32 AddDirtySums(BaseObject *op, Bool goDown, DIRTYFLAGS flags)
 }
 
 
+UInt64 HashMemory(const void *data, Int size, UInt64 hash)
+{
+	if (!data || size <= 0)
+		return hash;
+
+	// Process 8 bytes at a time, this is a lot faster than hashing single bytes for large arrays
+	const UChar *bytes = static_cast<const UChar*>(data);
+	const Int words = size / (Int)sizeof(UInt64);
+	for (Int i = 0; i < words; ++i)
+	{
+		UInt64 word;
+		CopyMemType(bytes + i * sizeof(UInt64), reinterpret_cast<UChar*>(&word), sizeof(UInt64));
+		hash = (hash ^ word) * 1099511628211ULL;
+		hash ^= hash >> 29;
+	}
+
+	// Remaining bytes
+	for (Int i = words * (Int)sizeof(UInt64); i < size; ++i)
+		hash = (hash ^ (UInt64)bytes[i]) * 1099511628211ULL;
+
+	return hash;
+}
+
+UInt64 HashGeometry(BaseObject *op, UInt64 hash)
+{
+	if (!op)
+		return hash;
+
+	// The local matrix places the geometry relative to the parent
+	const Matrix ml = op->GetMl();
+	hash = HashMemory(&ml, sizeof(ml), hash);
+
+	// Prefer the deformed state, then the generated geometry, then the object's own points
+	BaseObject *cache = op->GetDeformCache();
+	if (!cache)
+		cache = op->GetCache();
+	if (cache)
+	{
+		hash = HashGeometry(cache, hash);
+	}
+	else if (op->IsInstanceOf(Opoint))
+	{
+		const PointObject *pointOp = ToPoint(op);
+		const Int32 pointCount = pointOp->GetPointCount();
+		hash = HashMemory(&pointCount, sizeof(pointCount), hash);
+		hash = HashMemory(pointOp->GetPointR(), pointCount * sizeof(Vector), hash);
+
+		if (op->IsInstanceOf(Opolygon))
+		{
+			const PolygonObject *polyOp = ToPoly(op);
+			const Int32 polyCount = polyOp->GetPolygonCount();
+			hash = HashMemory(&polyCount, sizeof(polyCount), hash);
+			hash = HashMemory(polyOp->GetPolygonR(), polyCount * sizeof(CPolygon), hash);
+		}
+	}
+
+	// Children, e.g. the input objects of a generator or the objects in a group
+	for (BaseObject *child = op->GetDown(); child; child = child->GetNext())
+		hash = HashGeometry(child, hash);
+
+	return hash;
+}
+
+
+Bool IsRenderEvaluation(BaseDocument *doc, Int32 flags)
+{
+	// Renderers and exporters say so in the build flags
+	const BUILDFLAGS buildFlags = (BUILDFLAGS)flags;
+	if ((buildFlags & (BUILDFLAGS::INTERNALRENDERER | BUILDFLAGS::EXTERNALRENDERER | BUILDFLAGS::EXPORT)) != BUILDFLAGS::NONE)
+		return true;
+
+	// Rendering to the Picture Viewer, and most exporters, work on a clone of the active document.
+	// To be on the safe side, treat every document except the active one like that.
+	return doc && doc != GetActiveDocument();
+}
+
+Bool GetHierarchyPath(BaseObject *op, maxon::BaseArray<Int32> &path)
+{
+	path.Flush();
+	if (!op)
+		return false;
+
+	// Collect the indices from the bottom up, then reverse them
+	for (BaseObject *level = op; level; level = level->GetUp())
+	{
+		Int32 index = 0;
+		for (BaseObject *sibling = level->GetPred(); sibling; sibling = sibling->GetPred())
+			++index;
+		iferr (path.Append(index))
+			return false;
+	}
+
+	const Int count = path.GetCount();
+	for (Int i = 0; i < count / 2; ++i)
+	{
+		const Int32 tmp = path[i];
+		path[i] = path[count - 1 - i];
+		path[count - 1 - i] = tmp;
+	}
+	return true;
+}
+
+BaseObject *FindByHierarchyPath(BaseDocument *doc, const maxon::BaseArray<Int32> &path)
+{
+	if (!doc || path.IsEmpty())
+		return nullptr;
+
+	BaseObject *op = nullptr;
+	for (Int i = 0; i < path.GetCount(); ++i)
+	{
+		op = i == 0 ? doc->GetFirstObject() : op->GetDown();
+		for (Int32 index = 0; op && index < path[i]; ++index)
+			op = op->GetNext();
+		if (!op)
+			return nullptr;
+	}
+	return op;
+}
+
+
 FieldLayer* IterateNextFieldLayer(FieldLayer* layer)
 {
 	if (!layer)
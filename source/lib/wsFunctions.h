@@ -37,6 +37,87 @@ Bool GeneratesPolygons(BaseObject* op);
 /// @return The sum of the dirty checksums of all found objects
 UInt32 AddDirtySums(BaseObject *op, Bool goDown, DIRTYFLAGS flags);
 
+/// Computes a hash of a block of memory. Useful to find out if data has changed.
+/// @param data Pointer to the memory
+/// @param size Size of the memory in bytes
+/// @param hash Previous hash value, pass the result of a previous call here to combine several blocks of memory
+/// @return The hash value
+UInt64 HashMemory(const void *data, Int size, UInt64 hash = 14695981039346656037ULL);
+
+/// Computes a hash of the geometry an object and its children currently show. Deform caches and generator caches are used where they exist.
+/// @note Unlike dirty checksums, the result is the same in a clone of the document. Hashing large geometry takes time, though, so the result should be kept as long as the dirty checksums don't change.
+/// @param op The object
+/// @param hash Previous hash value, pass the result of a previous call here to combine several objects
+/// @return The hash value
+UInt64 HashGeometry(BaseObject *op, UInt64 hash = 14695981039346656037ULL);
+
+/// Finds out if an object is evaluated for rendering or export, rather than for display in the editor
+/// @param doc The document the object is evaluated in
+/// @param flags The flags passed to ObjectData::ModifyObject()
+/// @return True if the object is evaluated for rendering or export, otherwise false
+Bool IsRenderEvaluation(BaseDocument *doc, Int32 flags);
+
+/// Get the position of an object in the hierarchy of its document, as the index among its siblings on each level, starting at the top
+/// @param op The object
+/// @param path Receives the indices
+/// @return False if there was a problem, otherwise true
+Bool GetHierarchyPath(BaseObject *op, maxon::BaseArray<Int32> &path);
+
+/// Find an object in a document by its position in the hierarchy. Useful to find an object in a clone of its document.
+/// @param doc The document
+/// @param path Path returned by GetHierarchyPath()
+/// @return The object, or nullptr if the document's hierarchy is different
+BaseObject *FindByHierarchyPath(BaseDocument *doc, const maxon::BaseArray<Int32> &path);
+
+/// Write an array of plain values to a file, as a count followed by the raw bytes
+/// @param file An open file
+/// @param data Pointer to the first value
+/// @param count Number of values
+/// @return False if writing failed, otherwise true
+template <typename T> Bool WriteArrayToFile(BaseFile *file, const T *data, Int32 count)
+{
+	if (!file->WriteInt32(count))
+		return false;
+	return count == 0 || file->WriteBytes(data, count * sizeof(T));
+}
+
+/// Read an array written by WriteArrayToFile()
+/// @param file An open file
+/// @param array Receives the values
+/// @param expectedCount If not NOTOK, the count in the file must match it
+/// @return False if reading failed, the count didn't match, or the file is too short for the count, otherwise true
+template <typename T> Bool ReadArrayFromFile(BaseFile *file, maxon::BaseArray<T> &array, Int32 expectedCount = NOTOK)
+{
+	Int32 count = 0;
+	if (!file->ReadInt32(&count) || count < 0 || (expectedCount != NOTOK && count != expectedCount))
+		return false;
+
+	// A damaged file must not make us allocate more memory than there is data
+	if ((Int64)count * (Int64)sizeof(T) > file->GetLength() - file->GetPosition())
+		return false;
+
+	iferr (array.Resize(count))
+		return false;
+
+	return count == 0 || file->ReadBytes(array.GetFirst(), count * sizeof(T)) == count * (Int)sizeof(T);
+}
+
+/// Skips an array written by WriteArrayToFile(), without reading its values
+/// @param file An open file
+/// @return False if the count could not be read, or the file is too short for it, otherwise true
+template <typename T> Bool SkipArrayInFile(BaseFile *file)
+{
+	Int32 count = 0;
+	if (!file->ReadInt32(&count) || count < 0)
+		return false;
+
+	const Int64 size = (Int64)count * (Int64)sizeof(T);
+	if (size > file->GetLength() - file->GetPosition())
+		return false;
+
+	return count == 0 || file->Seek(size, FILESEEK::RELATIVE);
+}
+
 /// Returns the next FieldLayer in a FieldList
 /// @param layer The current layer
 /// @return The next layer
@@ -0,0 +1,328 @@
+#include "maxon/apibase.h"
+#include "wsPointCache.h"
+
+
+static const Int32 POINTCACHE_MAGIC = 0x4B505357;              ///< "WSPK", identifies point cache files
+static const Int32 POINTCACHE_VERSION = 1;                     ///< Increase when the file layout changes
+static const Int64 POINTCACHE_INDEX_POSITION = 8;              ///< Position of the index offset in the file, right after magic and version
+static const Int32 POINTCACHE_KEY_INTERVAL = 25;               ///< Every n-th frame is a keyframe, limits the number of frames decoded for random access
+static const Float POINTCACHE_MIN_STEP = 0.0001;               ///< Smallest quantization step, finer precisions are raised to this
+static const Int32 POINTCACHE_MAX_QUANTIZED = (1 << 30) - 1;   ///< Largest quantized position, so differences between frames still fit into Int32
+static const Int64 POINTCACHE_ENTRY_SIZE = 20;                 ///< Number of bytes of an index entry in the file
+static const Int32 POINTCACHE_MAX_VALUE_SIZE = 5;              ///< Maximum number of bytes of an encoded value
+
+
+/// Write a value with a variable number of bytes: Zigzag encoding maps small negative and positive values to small unsigned ones, and each byte carries 7 bits
+/// @return Position after the written bytes
+static inline UChar *EncodeValue(UChar *p, Int32 value)
+{
+	UInt32 zigzag = ((UInt32)value << 1) ^ (UInt32)(value >> 31);
+	while (zigzag >= 0x80)
+	{
+		*p++ = (UChar)(zigzag | 0x80);
+		zigzag >>= 7;
+	}
+	*p++ = (UChar)zigzag;
+	return p;
+}
+
+/// Read a value written by EncodeValue()
+/// @param p Position of the value, receives the position after it
+/// @param end End of the data
+/// @return False if the data ended before the value, otherwise true
+static inline Bool DecodeValue(const UChar *&p, const UChar *end, Int32 &value)
+{
+	UInt32 zigzag = 0;
+	for (Int32 shift = 0; shift < POINTCACHE_MAX_VALUE_SIZE * 7; shift += 7)
+	{
+		if (p >= end)
+			return false;
+
+		const UChar byte = *p++;
+		zigzag |= (UInt32)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			value = (Int32)(zigzag >> 1) ^ -(Int32)(zigzag & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+Bool wsPointCacheWriter::Open(const Filename &filename, Float precision)
+{
+	_frames.Reset();
+	_step = Max(precision, POINTCACHE_MIN_STEP);
+	_failed = false;
+	_outOfRange = false;
+	if (!_file || !_file->Open(filename, FILEOPEN::WRITE, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+		return false;
+
+	// Header. The position of the index is not known yet, it's written by Close().
+	return _file->WriteInt32(POINTCACHE_MAGIC) && _file->WriteInt32(POINTCACHE_VERSION) && _file->WriteInt64(0);
+}
+
+Bool wsPointCacheWriter::AddFrame(Int32 frame, const Vector *points, Int32 pointCount, UInt64 inputFingerprint)
+{
+	if (_failed || !_file || !points)
+		return false;
+
+	const Int32 index = GetFrameCount();
+	if (index > 0)
+	{
+		// The frame might be evaluated more than once
+		if (frame < _firstFrame + index)
+			return true;
+
+		if (frame != _firstFrame + index || pointCount != _pointCount)
+		{
+			_failed = true;
+			return false;
+		}
+	}
+	else
+	{
+		if (pointCount <= 0)
+		{
+			_failed = true;
+			return false;
+		}
+
+		// The quantization grid is centered on the first frame's bounding box, the step has been set by Open()
+		Vector boxMin(maxon::LIMIT<Float>::MAX), boxMax(maxon::LIMIT<Float>::MIN);
+		for (Int32 i = 0; i < pointCount; ++i)
+		{
+			boxMin = Vector(Min(boxMin.x, points[i].x), Min(boxMin.y, points[i].y), Min(boxMin.z, points[i].z));
+			boxMax = Vector(Max(boxMax.x, points[i].x), Max(boxMax.y, points[i].y), Max(boxMax.z, points[i].z));
+		}
+		_origin = (boxMin + boxMax) * 0.5;
+		_firstFrame = frame;
+		_pointCount = pointCount;
+
+		// Worst case size of an encoded frame, so encoding doesn't need to check
+		iferr (_previous.Resize((Int)pointCount * 3))
+		{
+			_failed = true;
+			return false;
+		}
+		iferr (_buffer.Resize((Int)pointCount * 3 * POINTCACHE_MAX_VALUE_SIZE))
+		{
+			_failed = true;
+			return false;
+		}
+	}
+
+	// Keyframes store the quantized positions, all other frames the difference to the previous frame
+	const Bool keyframe = index % POINTCACHE_KEY_INTERVAL == 0;
+	const Float inverseStep = 1.0 / _step;
+	UChar *p = _buffer.GetFirst();
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		for (Int32 axis = 0; axis < 3; ++axis)
+		{
+			const Float scaled = Floor((points[i][axis] - _origin[axis]) * inverseStep + 0.5);
+
+			// A point that moved too far from the grid's origin can't be stored with this step. Clamping it would bake wrong positions.
+			if (!(Abs(scaled) <= (Float)POINTCACHE_MAX_QUANTIZED))
+			{
+				_failed = true;
+				_outOfRange = true;
+				return false;
+			}
+			const Int32 quantized = (Int32)scaled;
+			Int32 &previous = _previous[(Int)i * 3 + axis];
+			p = EncodeValue(p, keyframe ? quantized : quantized - previous);
+			previous = quantized;
+		}
+	}
+
+	wsPointCacheFrame entry;
+	entry._offset = _file->GetPosition();
+	entry._size = (Int32)(p - _buffer.GetFirst());
+	entry._fingerprint = inputFingerprint;
+	if (!_file->WriteBytes(_buffer.GetFirst(), entry._size))
+	{
+		_failed = true;
+		return false;
+	}
+	iferr (_frames.Append(entry))
+	{
+		_failed = true;
+		return false;
+	}
+
+	return true;
+}
+
+Bool wsPointCacheWriter::Close()
+{
+	if (!_file)
+		return false;
+
+	// Index
+	const Int64 indexOffset = _file->GetPosition();
+	_file->WriteInt32(_pointCount);
+	_file->WriteInt32(_firstFrame);
+	_file->WriteInt32(POINTCACHE_KEY_INTERVAL);
+	_file->WriteVector64(_origin);
+	_file->WriteFloat64(_step);
+	_file->WriteInt32(GetFrameCount());
+	for (const wsPointCacheFrame &entry : _frames)
+	{
+		_file->WriteInt64(entry._offset);
+		_file->WriteInt32(entry._size);
+		_file->WriteUInt64(entry._fingerprint);
+	}
+
+	// Now the header can point to the index
+	_file->Seek(POINTCACHE_INDEX_POSITION, FILESEEK::START);
+	_file->WriteInt64(indexOffset);
+
+	// BaseFile remembers write errors, Close() reports them
+	const Bool success = _file->Close();
+	return success && !_failed && !_frames.IsEmpty();
+}
+
+
+Bool wsPointCache::Open(const Filename &filename)
+{
+	Close();
+	_filename = filename;
+	if (!_file || !_file->Open(filename, FILEOPEN::READ, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+		return false;
+
+	// Header
+	Int32 magic = 0;
+	Int32 version = 0;
+	Int64 indexOffset = 0;
+	if (!_file->ReadInt32(&magic) || !_file->ReadInt32(&version) || !_file->ReadInt64(&indexOffset) || magic != POINTCACHE_MAGIC || version != POINTCACHE_VERSION || indexOffset <= POINTCACHE_INDEX_POSITION)
+	{
+		Close();
+		_filename = filename;
+		return false;
+	}
+
+	// Index
+	Int32 frameCount = 0;
+	Bool success = _file->Seek(indexOffset, FILESEEK::START);
+	success = success && _file->ReadInt32(&_pointCount) && _file->ReadInt32(&_firstFrame) && _file->ReadInt32(&_keyInterval);
+	success = success && _file->ReadVector64(&_origin) && _file->ReadFloat64(&_step) && _file->ReadInt32(&frameCount);
+	success = success && _pointCount > 0 && _keyInterval > 0 && _step > 0.0 && frameCount > 0;
+
+	// A damaged file must not make us allocate more memory than there is data
+	success = success && (Int64)frameCount * POINTCACHE_ENTRY_SIZE <= _file->GetLength() - _file->GetPosition();
+	if (success)
+	{
+		iferr (_frames.Resize(frameCount))
+			success = false;
+	}
+
+	Int32 maxSize = 0;
+	if (success)
+	{
+		for (wsPointCacheFrame &entry : _frames)
+		{
+			_file->ReadInt64(&entry._offset);
+			_file->ReadInt32(&entry._size);
+			_file->ReadUInt64(&entry._fingerprint);
+			maxSize = Max(maxSize, entry._size);
+		}
+		success = _file->GetError() == FILEERROR::NONE && maxSize > 0;
+	}
+
+	// Decoding buffers are allocated once, so playback doesn't allocate memory
+	if (success)
+	{
+		iferr (_quantized.Resize((Int)_pointCount * 3))
+			success = false;
+	}
+	if (success)
+	{
+		iferr (_buffer.Resize(maxSize))
+			success = false;
+	}
+
+	if (!success)
+	{
+		Close();
+		_filename = filename;
+		return false;
+	}
+
+	return true;
+}
+
+void wsPointCache::Close()
+{
+	if (_file)
+		_file->Close();
+	_filename = Filename();
+	_frames.Reset();
+	_quantized.Reset();
+	_buffer.Reset();
+	_pointCount = 0;
+	_decodedFrame = NOTOK;
+}
+
+Bool wsPointCache::DecodeFrame(Int32 index)
+{
+	const wsPointCacheFrame &entry = _frames[index];
+	if (entry._size <= 0 || entry._size > _buffer.GetCount())
+		return false;
+
+	if (!_file->Seek(entry._offset, FILESEEK::START) || _file->ReadBytes(_buffer.GetFirst(), entry._size) != entry._size)
+		return false;
+
+	// Keyframes contain the quantized positions, all other frames the difference to the previous frame
+	const Bool keyframe = index % _keyInterval == 0;
+	const UChar *p = _buffer.GetFirst();
+	const UChar *end = p + entry._size;
+	for (Int32 &quantized : _quantized)
+	{
+		Int32 value = 0;
+		if (!DecodeValue(p, end, value))
+			return false;
+		quantized = keyframe ? value : quantized + value;
+	}
+
+	return true;
+}
+
+Bool wsPointCache::GetFrame(Int32 frame, UInt64 inputFingerprint, Vector *points, Int32 pointCount)
+{
+	if (!IsOpen() || !points || pointCount != _pointCount)
+		return false;
+
+	// The frame must be in the cache, and it must have been baked from the same input
+	const Int32 index = frame - _firstFrame;
+	if (index < 0 || index >= (Int32)_frames.GetCount() || _frames[index]._fingerprint != inputFingerprint)
+		return false;
+
+	if (index != _decodedFrame)
+	{
+		// Continue from the last decoded frame if it's on the way, otherwise start at the nearest keyframe
+		Int32 start = index - index % _keyInterval;
+		if (_decodedFrame != NOTOK && _decodedFrame >= start && _decodedFrame < index)
+			start = _decodedFrame + 1;
+
+		for (Int32 i = start; i <= index; ++i)
+		{
+			if (!DecodeFrame(i))
+			{
+				_decodedFrame = NOTOK;
+				return false;
+			}
+		}
+		_decodedFrame = index;
+	}
+
+	// Back from the quantization grid
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		const Int32 *quantized = _quantized.GetFirst() + (Int)i * 3;
+		points[i] = _origin + Vector((Float)quantized[0], (Float)quantized[1], (Float)quantized[2]) * _step;
+	}
+
+	return true;
+}
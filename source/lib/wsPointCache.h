@@ -0,0 +1,129 @@
+#ifndef WS_POINTCACHE_H__
+#define WS_POINTCACHE_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+
+
+/// Entry of the index of a point cache file
+struct wsPointCacheFrame
+{
+	Int64  _offset = 0;       ///< Position of the frame's data in the file
+	Int32  _size = 0;         ///< Number of bytes of the frame's data
+	UInt64 _fingerprint = 0;  ///< Fingerprint of the input the frame was baked from
+};
+
+
+/// Writes the baked points of consecutive frames to a point cache file.
+/// Positions are quantized on a grid with a fixed step, centered on the bounding box of the first frame. Every few frames, a keyframe stores the quantized positions.
+/// Frames with points too far from the grid's center for the step are not written, so a precision that's too fine fails instead of baking wrong positions.
+/// All other frames only store the difference to the previous frame, which is very small (or zero) for most points, and is written with a variable number of bytes.
+class wsPointCacheWriter
+{
+private:
+	AutoAlloc<BaseFile>                  _file;        ///< The file that's being written
+	maxon::BaseArray<wsPointCacheFrame>  _frames;      ///< Index of the frames written so far
+	maxon::BaseArray<Int32>              _previous;    ///< Quantized positions of the previous frame
+	maxon::BaseArray<UChar>              _buffer;      ///< Encoded data of the current frame
+	Vector                               _origin;      ///< Position that's quantized to zero
+	Float                                _step;        ///< Size of a quantization step
+	Int32                                _pointCount;  ///< Number of points in each frame
+	Int32                                _firstFrame;  ///< Number of the first frame
+	Bool                                 _failed;      ///< Indicates if a frame could not be written
+	Bool                                 _outOfRange;  ///< Indicates if a frame had points outside of the quantization range
+
+public:
+	/// Create the file
+	/// @param filename The file to write
+	/// @param precision Size of a quantization step. Each coordinate can be up to 2^30 steps away from the center of the first frame.
+	/// @return False if the file could not be created, otherwise true
+	Bool Open(const Filename &filename, Float precision);
+
+	/// Write the points of a frame. Frames must be added in order, without gaps. A frame that has already been written is ignored.
+	/// @param frame Number of the frame
+	/// @param points The baked points (local space of the deformed object)
+	/// @param pointCount Number of points, must be the same in all frames
+	/// @param inputFingerprint Fingerprint of the input the points were baked from. Playback only uses the frame if the input still matches.
+	/// @return False if the frame could not be written, otherwise true
+	Bool AddFrame(Int32 frame, const Vector *points, Int32 pointCount, UInt64 inputFingerprint);
+
+	/// Write the index, and close the file
+	/// @return False if writing failed or a frame could not be added, otherwise true
+	Bool Close();
+
+	/// @return True if a frame could not be written because its points were outside of the quantization range
+	Bool IsOutOfRange() const
+	{
+		return _outOfRange;
+	}
+
+	/// @return Number of frames written so far
+	Int32 GetFrameCount() const
+	{
+		return (Int32)_frames.GetCount();
+	}
+
+	/// Default constructor
+	wsPointCacheWriter() : _step(1.0), _pointCount(0), _firstFrame(0), _failed(false), _outOfRange(false)
+	{ }
+};
+
+
+/// Reads frames from a point cache file written by wsPointCacheWriter.
+/// Only the index is kept in memory. Frames are streamed from the file when they're requested, so a cache of any length plays back with constant memory.
+/// Frames that follow the previously read one are decoded from its result, random access decodes forward from the nearest keyframe.
+class wsPointCache
+{
+private:
+	AutoAlloc<BaseFile>                  _file;          ///< The cache file, kept open for reading frames
+	Filename                             _filename;      ///< The file passed to Open(), even if it could not be opened
+	maxon::BaseArray<wsPointCacheFrame>  _frames;        ///< Index of all frames
+	maxon::BaseArray<Int32>              _quantized;     ///< Quantized positions of the last decoded frame
+	maxon::BaseArray<UChar>              _buffer;        ///< Encoded data of the frame that's being decoded
+	Vector                               _origin;        ///< Position that's quantized to zero
+	Float                                _step;          ///< Size of a quantization step
+	Int32                                _pointCount;    ///< Number of points in each frame
+	Int32                                _firstFrame;    ///< Number of the first frame
+	Int32                                _keyInterval;   ///< Every n-th frame is a keyframe
+	Int32                                _decodedFrame;  ///< Index of the frame in _quantized, or NOTOK
+
+	/// Read a frame, and apply it to _quantized
+	/// @param index Index of the frame. Unless it's a keyframe, _quantized must contain the previous frame.
+	Bool DecodeFrame(Int32 index);
+
+public:
+	/// Open a point cache file, and read the index
+	/// @param filename The file written by wsPointCacheWriter
+	/// @return False if the file could not be read, otherwise true
+	Bool Open(const Filename &filename);
+
+	/// Free the index, and close the file
+	void Close();
+
+	/// @return True if a point cache file is open
+	Bool IsOpen() const
+	{
+		return !_frames.IsEmpty();
+	}
+
+	/// @return The file passed to the last call of Open(), it's kept even if the file could not be opened. Can be used to find out if the file has to be opened again.
+	const Filename &GetFilename() const
+	{
+		return _filename;
+	}
+
+	/// Get the points of a frame
+	/// @param frame Number of the frame
+	/// @param inputFingerprint Fingerprint of the current input. The frame is only used if it has been baked from the same input.
+	/// @param points Receives the points
+	/// @param pointCount Number of points, must match the cache
+	/// @return False if the frame is not in the cache, the input doesn't match, or reading failed. The points are not changed in that case.
+	Bool GetFrame(Int32 frame, UInt64 inputFingerprint, Vector *points, Int32 pointCount);
+
+	/// Default constructor
+	wsPointCache() : _step(1.0), _pointCount(0), _firstFrame(0), _keyInterval(1), _decodedFrame(NOTOK)
+	{ }
+};
+
+#endif // WS_POINTCACHE_H__
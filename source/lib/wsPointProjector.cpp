@@ -27,156 +27,639 @@ InitUnsuccessful:
 	return false;
 }
 
-Bool wsPointProjector::ProjectPosition(Vector &position, const Vector &rayDirection, Float rayLength, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset, Float blend)
+Bool wsPointProjector::IntersectRay(const Vector &position, const Vector &rayDirection, Float rayLength, PROJECTORDIRECTION direction, Vector &hitPosition, Vector *hitNormal)
+{
+	// Bidirectional rays are shot at the collision mesh, which finds the nearest hit on both sides in a single traversal
+	if (direction != PROJECTORDIRECTION::FORWARD)
+	{
+		wsCollisionMeshHit hit;
+		if (!_mesh.IntersectLine(position, rayDirection, rayLength, direction == PROJECTORDIRECTION::BOTH_PREFERFORWARD, hit))
+			return false;
+
+		hitPosition = hit._position;
+		if (hitNormal)
+			*hitNormal = _mesh.GetInterpolatedNormal(hit);
+		return true;
+	}
+
+	// Nothing hit, the ray simply shot into the void
+	if (!_collider->Intersect(position, rayDirection, rayLength, false))
+		return false;
+
+	// Get collision result
+	GeRayColResult collisionResult;
+	if (!_collider->GetNearestIntersection(&collisionResult))
+		return false;
+
+	hitPosition = collisionResult.hitpos;
+	if (hitNormal)
+	{
+		// Use the precomputed vertex normals of the collision mesh, the collider's shading normal is only a fallback
+		if (!_mesh.IsInitialized() || !_mesh.GetInterpolatedNormal(collisionResult.face_id, hitPosition, *hitNormal))
+			*hitNormal = collisionResult.s_normal.GetNormalized();
+	}
+	return true;
+}
+
+Bool wsPointProjector::FindClosest(const Vector &position, Float localMaxDistance, Float maxDistanceSquared, const Matrix &collisionObjectMg, Vector &hitPosition, Vector *hitNormal) const
+{
+	// Nothing within reach
+	wsCollisionMeshHit hit;
+	if (_sdf.IsInitialized())
+	{
+		if (!_sdf.GetClosestPoint(_mesh, position, localMaxDistance, hit))
+			return false;
+	}
+	else if (!_mesh.GetClosestPoint(position, localMaxDistance, hit))
+	{
+		return false;
+	}
+
+	// The local radius might have been too generous, check the actual distance in global space
+	if (maxDistanceSquared > 0.0 && (collisionObjectMg.sqmat * (hit._position - position)).GetSquaredLength() > maxDistanceSquared)
+		return false;
+
+	hitPosition = hit._position;
+	if (hitNormal)
+		*hitNormal = _mesh.GetInterpolatedNormal(hit);
+	return true;
+}
+
+/// Scale a global search radius or ray length to the local space of a matrix
+/// The Frobenius norm of the inverted matrix is never smaller than its largest scale, so no surface within the radius is missed.
+static inline Float GetLocalSearchDistance(Float maxDistance, const Matrix &mgI)
+{
+	if (maxDistance <= 0.0)
+		return 0.0;
+	return maxDistance * Sqrt(mgI.sqmat.v1.GetSquaredLength() + mgI.sqmat.v2.GetSquaredLength() + mgI.sqmat.v3.GetSquaredLength());
+}
+
+Bool wsPointProjector::ProjectPosition(Vector &position, const Vector &rayDirection, Float rayLength, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset, Float blend, PROJECTORDIRECTION direction)
 {
 	if (!_initialized || !_collider || !_collisionObject)
 		return false;
 	
-	if (rayLength <= 0.0 || rayDirection == Vector())
+	if (direction != PROJECTORDIRECTION::FORWARD && !_mesh.HasHierarchy())
 		return false;
 
-	Vector workPosition = collisionObjectMgI * position;            // Transform position to m_collop's local space
-	GeRayColResult collisionResult;
-	Vector rPos(workPosition);
+	// A ray without length or direction doesn't hit anything, the point stays where it is (e.g. a point right at the modifier's position in spherical mode)
+	if (rayLength <= 0.0 || rayDirection == Vector())
+		return true;
+
+	Vector rPos(collisionObjectMgI * position);            // Transform position to m_collop's local space
 	Vector rDir(collisionObjectMgI.sqmat * rayDirection);  // Transform direction to m_collop's local space
 
-	if (_collider->Intersect(rPos, rDir, rayLength, false))
+	// Return true if no intersection was found, as this is not a critical problem (the ray simply shot into the void, nothing happens)
+	Vector workPosition(DC);
+	Vector normal(DC);
+	if (!IntersectRay(rPos, rDir, GetLocalSearchDistance(rayLength, collisionObjectMgI), direction, workPosition, offset != 0.0 ? &normal : nullptr))
+		return true;
+
+	// Apply offset
+	if (offset != 0.0)
+		workPosition += normal * offset;
+
+	// Apply blend
+	if (blend != 1.0)
+		workPosition = Blend(rPos, workPosition, blend);
+
+	// Transform position back to global space
+	position = collisionObjectMg * workPosition;
+
+	return true;
+}
+
+Bool wsPointProjector::ProjectPositionClosest(Vector &position, Float maxDistance, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset, Float blend)
+{
+	if (!_initialized || !_collisionObject || !_mesh.HasHierarchy())
+		return false;
+
+	Vector rPos(collisionObjectMgI * position);  // Transform position to m_collop's local space
+
+	// Return true if nothing was found, as this is not a critical problem (there's simply no surface within reach, nothing happens)
+	Vector workPosition(DC);
+	Vector normal(DC);
+	if (!FindClosest(rPos, GetLocalSearchDistance(maxDistance, collisionObjectMgI), maxDistance * maxDistance, collisionObjectMg, workPosition, offset != 0.0 ? &normal : nullptr))
+		return true;
+
+	// Apply offset
+	if (offset != 0.0)
+		workPosition += normal * offset;
+
+	// Apply blend
+	if (blend != 1.0)
+		workPosition = Blend(rPos, workPosition, blend);
+
+	// Transform position back to global space
+	position = collisionObjectMg * workPosition;
+
+	return true;
+}
+
+Bool wsPointProjector::ProjectPoint(Vector &rayPosition, Vector &rayDirection, Float rayLength, const wsPointProjectorParams &params, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI)
+{
+	// Calculate ray direction for spherical projection
+	// This needs to be done for each point, as the direction is different for each point
+	if (params._mode == PROJECTORMODE::SPHERICAL)
 	{
-		// Get collision result
-		// Return true if no intersection was found, as this is not a critical problem (the ray simply shot into the void, nothing happens)
-		if (!_collider->GetNearestIntersection(&collisionResult))
-			return true;
+		// Direction points from the modifier to the position of the point
+		rayDirection = rayPosition - params._modifierMg.off;
+	}
+
+	if (params._mode == PROJECTORMODE::CLOSESTPOINT)
+		return ProjectPositionClosest(rayPosition, params._maxSearchDist, collisionObjectMg, collisionObjectMgI, params._offset, params._blend);
+
+	return ProjectPosition(rayPosition, rayDirection, rayLength, collisionObjectMg, collisionObjectMgI, params._offset, params._blend, params._direction);
+}
+
+void wsPointProjector::ApplyFalloffs(Vector &rayPosition, const Vector &originalRayPosition, Int32 index, const wsPointProjectorParams &params) const
+{
+	// Calculate geometry falloff
+	if (params._geometryFalloffEnabled)
+	{
+		// Square the falloff distance
+		Float maxDistSquared = params._geometryFalloffDist * params._geometryFalloffDist;
 		
-		workPosition = collisionResult.hitpos;
+		// Get squared length vector from original ray position to resulting ray position
+		// We're using squared distances here, to avoid calculate expensive square roots
+		Float distanceSquared = (rayPosition - originalRayPosition).GetSquaredLength();
 		
-		// Apply offset
-		if (offset != 0.0)
-			workPosition += collisionResult.s_normal.GetNormalized() * offset;
+		// If within falloff range
+		if (distanceSquared < maxDistSquared)
+		{
+			// Calculate blend value using a smooth step interpolation
+			Float blendVal = Smoothstep(0.0, maxDistSquared, distanceSquared);
+			rayPosition = Blend(rayPosition, originalRayPosition, blendVal);
+		}
+		else
+		{
+			rayPosition = originalRayPosition;
+		}
+	}
+
+	// Evaluate falloff
+	if (params.HasFalloff())
+	{
+		// Get falloff value at original position
+		const Float falloffResult = _falloffValues[index];
 		
-		// Apply blend
-		if (blend != 1.0)
-			workPosition = Blend(rPos, workPosition, blend);
+		// Only perform blending if necessary
+		if (falloffResult < 1.0)
+			rayPosition = Blend(originalRayPosition, rayPosition, falloffResult);
+	}
+	
+	// Evaluate eight map
+	if (params._weightMap)
+	{
+		// Get weight value for this point form map
+		Float32 weight = params._weightMap[index];
 		
-		// Transform position back to global space
-		position = collisionObjectMg * workPosition;
+		// Only perform blending if necessary
+		if (weight < 1.0)
+			rayPosition = Blend(originalRayPosition, rayPosition, weight);
+	}
+}
+
+Bool wsPointProjector::SampleFalloff(PointObject *op, const wsPointProjectorParams &params, const Matrix &opMg)
+{
+	if (!params.HasFalloff())
+		return true;
+
+	// Once the array has grown to the point count, no more memory is allocated
+	const Int32 pointCount = op->GetPointCount();
+	iferr (_falloffValues.Resize(pointCount))
+		return false;
+
+	// Values have been sampled before
+	if (params._falloffValues)
+	{
+		CopyMem(params._falloffValues, _falloffValues.GetFirst(), pointCount * sizeof(Float));
+		return true;
+	}
+
+	// Sample falloff at the original positions in global space
+	const Vector *padr = op->GetPointR();
+	for (Int32 i = 0; i < pointCount; i++)
+	{
+		Float falloffResult = 1.0;
+		params._falloff->Sample(opMg * padr[i], &falloffResult);
+		_falloffValues[i] = falloffResult;
 	}
 
 	return true;
 }
 
-Bool wsPointProjector::Project(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread)
+Bool wsPointProjector::BuildCollisionCaches(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, BaseThread *thread)
 {
-	if (!_initialized || !_collider || !_collisionObject || !op)
+	if (!_initialized || !_collisionObject)
 		return false;
-	
-	// Get point count
-	const Int32 pointCount = op->GetPointCount();
-	if (pointCount == 0)
-		return false;
-	
-	// Get writable point array
-	Vector *padr = op->GetPointW();
-	if (!padr)
+
+	// Bidirectional rays query the collision mesh, so they need its hierarchy. Smooth normals for forward rays only need its triangles and vertex normals.
+	// It's only rebuilt if the geometry changed.
+	if (mode != PROJECTORMODE::CLOSESTPOINT && NeedsCollisionMesh(mode, direction, smoothNormals))
+	{
+		if (!_mesh.Init(_collisionObject, false, NeedsCollisionHierarchy(mode, direction), thread))
+			return false;
+	}
+
+	// If using closest point projection, make sure the collision mesh (and the distance field, if requested) is built.
+	// Both are only rebuilt if the geometry changed.
+	if (mode == PROJECTORMODE::CLOSESTPOINT)
+	{
+		if (!_mesh.Init(_collisionObject, false, true, thread))
+			return false;
+
+		if (sdfResolution > 0)
+		{
+			if (!_sdf.Init(_mesh, sdfResolution, thread))
+				return false;
+		}
+		else
+		{
+			_sdf.Reset();
+		}
+	}
+
+	return true;
+}
+
+Bool wsPointProjector::PrepareProjection(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread, ProjectionContext &context)
+{
+	if (!_initialized || !_collider || !_collisionObject || !op)
 		return false;
 	
 	// Get global Matrix of collision object and op (precalculated for better performance)
-	const Matrix collisionObjectMg = _collisionObject->GetMg();
-	const Matrix opMg = op->GetMg();
+	context._collisionObjectMg = _collisionObject->GetMg();
+	context._opMg = op->GetMg();
 	
 	// Also calculate the inversions of both matrices (precalculated for better performance)
-	const Matrix collisionObjectMgI = ~collisionObjectMg;
-	const Matrix opMgI = ~opMg;
-	
-	// Ray position in gobal space. Don't construct yet (DC), they will be receiving values soon enough.
-	Vector rayPosition(DC);
-	Vector originalRayPosition(DC);
-	
-	// Ray direction in global space Don't construct yet (DC), it will be receiving a value soon enough.
-	Vector rayDirection(DC);
+	context._collisionObjectMgI = ~context._collisionObjectMg;
+	context._opMgI = ~context._opMg;
 	
 	// If using parallel projection, calculate rayDirection now, as it's the same for all points
 	if (params._mode == PROJECTORMODE::PARALLEL)
 	{
 		// Direction points along the modifier's Z axis
-		rayDirection = params._modifierMg.sqmat.v3;
+		context._rayDirection = params._modifierMg.sqmat.v3;
 	}
 	
+	// Build the collision caches needed by the selected mode
+	if (!BuildCollisionCaches(params._mode, params._direction, params._sdfResolution, params._offset != 0.0, thread))
+		return false;
+	
 	// Calculate a ray length.
 	// The resulting length might be a bit too long, but with this we're on the safe side. No ray should ever be too short to reach the collision geometry.
-	Float rayLength = (collisionObjectMg.off - opMg.off).GetLength() + _collisionObject->GetRad().GetSum()+ op->GetRad().GetSum();
+	context._rayLength = (context._collisionObjectMg.off - context._opMg.off).GetLength() + _collisionObject->GetRad().GetSum()+ op->GetRad().GetSum();
+
+	// Fold the transforms, so the kernels need only one matrix multiplication on the way to the collision object's local space, and one on the way back
+	context._opToCollision = context._collisionObjectMgI * context._opMg;
+	context._collisionToOp = context._opMgI * context._collisionObjectMg;
+	context._localRayDirection = context._collisionObjectMgI.sqmat * context._rayDirection;
+	context._localModifierPosition = context._collisionObjectMgI * params._modifierMg.off;
+	context._localRayLength = GetLocalSearchDistance(context._rayLength, context._collisionObjectMgI);
+	context._localMaxSearchDist = GetLocalSearchDistance(params._maxSearchDist, context._collisionObjectMgI);
+	context._maxSearchDistSquared = params._maxSearchDist * params._maxSearchDist;
+	context._geometryFalloffDistSquared = params._geometryFalloffDist * params._geometryFalloffDist;
+
+	return true;
+}
+
+template <PROJECTORMODE MODE, Bool OFFSET, Bool BLEND, Bool GEOMETRYFALLOFF, Bool FALLOFF, Bool WEIGHTMAP>
+Bool wsPointProjector::ProjectPoints(Vector *padr, Int32 pointCount, const wsPointProjectorParams &params, const ProjectionContext &context, BaseThread *thread)
+{
+	Vector hitPosition(DC);
+	Vector hitNormal(DC);
 
-	// Iterate points
 	for (Int32 i = 0; i < pointCount; i++)
 	{
 		// Check if procesing should be cancelled
 		if (thread && !(i & 63) && thread->TestBreak())
 			break;
 
-		// Transform point position to global space
-		rayPosition = opMg * padr[i];
-		originalRayPosition = rayPosition;
+		// Transform point position to the collision object's local space
+		const Vector originalPosition = context._opToCollision * padr[i];
+		Vector position = originalPosition;
 
-		// Calculate ray direction for spherical projection
-		// This needs to be done inside the loop, as the direction is different for each point
-		if (params._mode == PROJECTORMODE::SPHERICAL)
+		// Find the hit position
+		Bool hit;
+		if (MODE == PROJECTORMODE::CLOSESTPOINT)
+			hit = FindClosest(originalPosition, context._localMaxSearchDist, context._maxSearchDistSquared, context._collisionObjectMg, hitPosition, OFFSET ? &hitNormal : nullptr);
+		else if (MODE == PROJECTORMODE::SPHERICAL)
 		{
-			// Direction points from the modifier to the position of the point
-			rayDirection = rayPosition - params._modifierMg.off;
+			// Direction points from the modifier to the position of the point. A point right at the modifier's position doesn't have one.
+			const Vector rayDirection = originalPosition - context._localModifierPosition;
+			hit = rayDirection != Vector() && IntersectRay(originalPosition, rayDirection, context._localRayLength, params._direction, hitPosition, OFFSET ? &hitNormal : nullptr);
 		}
-		
-		// Project point, cancel if critical error occurred
-		if (!ProjectPosition(rayPosition, rayDirection, rayLength, collisionObjectMg, collisionObjectMgI, params._offset, params._blend))
-			return false;
-		
-		// Calculate geometry falloff
-		if (params._geometryFalloffEnabled)
+		else
+			hit = IntersectRay(originalPosition, context._localRayDirection, context._localRayLength, params._direction, hitPosition, OFFSET ? &hitNormal : nullptr);
+
+		if (hit)
+		{
+			position = hitPosition;
+
+			// Apply offset
+			if (OFFSET)
+				position += hitNormal * params._offset;
+
+			// Apply blend
+			if (BLEND)
+				position = Blend(originalPosition, position, params._blend);
+		}
+
+		// Calculate geometry falloff. The distance is measured in global space.
+		if (GEOMETRYFALLOFF)
 		{
-			// Square the falloff distance
-			Float maxDistSquared = params._geometryFalloffDist * params._geometryFalloffDist;
-			
-			// Get squared length vector from original ray position to resulting ray position
-			// We're using squared distances here, to avoid calculate expensive square roots
-			Float distanceSquared = (rayPosition - originalRayPosition).GetSquaredLength();
-			
-			// If within falloff range
-			if (distanceSquared < maxDistSquared)
-			{
-				// Calculate blend value using a smooth step interpolation
-				Float blendVal = Smoothstep(0.0, maxDistSquared, distanceSquared);
-				rayPosition = Blend(rayPosition, originalRayPosition, blendVal);
-			}
+			const Float distanceSquared = (context._collisionObjectMg.sqmat * (position - originalPosition)).GetSquaredLength();
+			if (distanceSquared < context._geometryFalloffDistSquared)
+				position = Blend(position, originalPosition, Smoothstep(0.0, context._geometryFalloffDistSquared, distanceSquared));
 			else
-			{
-				rayPosition = originalRayPosition;
-			}
+				position = originalPosition;
 		}
 
-		// Evaluate falloff
-		if (params._falloff)
+		// Evaluate falloff, it has been sampled at the original position before
+		if (FALLOFF)
 		{
-			// Sample falloff value at original position
-			Float falloffResult = 1.0;
-			params._falloff->Sample(originalRayPosition, &falloffResult);
-			
-			// Only perform blending if necessary
+			const Float falloffResult = _falloffValues[i];
 			if (falloffResult < 1.0)
-				rayPosition = Blend(originalRayPosition, rayPosition, falloffResult);
+				position = Blend(originalPosition, position, falloffResult);
 		}
-		
-		// Evaluate eight map
-		if (params._weightMap)
+
+		// Evaluate weight map
+		if (WEIGHTMAP)
 		{
-			// Get weight value for this point form map
-			Float32 weight = params._weightMap[i];
-			
-			// Only perform blending if necessary
+			const Float32 weight = params._weightMap[i];
 			if (weight < 1.0)
-				rayPosition = Blend(originalRayPosition, rayPosition, weight);
+				position = Blend(originalPosition, position, (Float)weight);
+		}
+
+		// Transform point position back to op's local space
+		padr[i] = context._collisionToOp * position;
+	}
+
+	return true;
+}
+
+/// Fills the table of projection kernels. The bits of INDEX select mode and features, see wsPointProjector::GetProjectKernel().
+template <Int32 INDEX>
+struct wsProjectKernelTable
+{
+	static void Fill(wsPointProjector::ProjectKernel *table)
+	{
+		static constexpr PROJECTORMODE mode = (INDEX >> 5) == 0 ? PROJECTORMODE::PARALLEL : ((INDEX >> 5) == 1 ? PROJECTORMODE::SPHERICAL : PROJECTORMODE::CLOSESTPOINT);
+		table[INDEX] = &wsPointProjector::ProjectPoints<mode, (INDEX & 16) != 0, (INDEX & 8) != 0, (INDEX & 4) != 0, (INDEX & 2) != 0, (INDEX & 1) != 0>;
+		wsProjectKernelTable<INDEX - 1>::Fill(table);
+	}
+};
+
+template <>
+struct wsProjectKernelTable<-1>
+{
+	static void Fill(wsPointProjector::ProjectKernel*)
+	{ }
+};
+
+wsPointProjector::ProjectKernel wsPointProjector::GetProjectKernel(const wsPointProjectorParams &params)
+{
+	static const Int32 KERNEL_COUNT = 3 * 32;
+
+	// Built once, on first use
+	static const struct KernelTable
+	{
+		ProjectKernel _kernels[KERNEL_COUNT];
+
+		KernelTable()
+		{
+			wsProjectKernelTable<KERNEL_COUNT - 1>::Fill(_kernels);
 		}
+	} table;
+
+	Int32 modeIndex;
+	switch (params._mode)
+	{
+		case PROJECTORMODE::PARALLEL:
+			modeIndex = 0;
+			break;
+
+		case PROJECTORMODE::SPHERICAL:
+			modeIndex = 1;
+			break;
+
+		case PROJECTORMODE::CLOSESTPOINT:
+			modeIndex = 2;
+			break;
+
+		default:
+			return nullptr;
+	}
+
+	const Int32 index = (modeIndex << 5)
+		| (params._offset != 0.0 ? 16 : 0)
+		| (params._blend != 1.0 ? 8 : 0)
+		| (params._geometryFalloffEnabled ? 4 : 0)
+		| (params.HasFalloff() ? 2 : 0)
+		| (params._weightMap ? 1 : 0);
+	return table._kernels[index];
+}
+
+Bool wsPointProjector::ProjectDisplacements(PointObject *op, const wsPointProjectorParams &params, const ProjectionContext &context, const Int32 *indices, Int32 count, Vector *displacements, Int32 &processed, BaseThread *thread, Float64 deadline)
+{
+	static const Int32 CHUNK_SIZE = 64;
+
+	processed = 0;
+	if (!indices || !displacements)
+		return false;
+
+	const Vector *padr = op ? op->GetPointR() : nullptr;
+	if (!padr)
+		return false;
+
+	// Falloffs are applied later to all points, so the kernel only does the projection itself
+	wsPointProjectorParams kernelParams = params;
+	kernelParams._geometryFalloffEnabled = false;
+	kernelParams._weightMap = nullptr;
+	kernelParams._falloff = nullptr;
+	kernelParams._falloffValues = nullptr;
+	const ProjectKernel kernel = GetProjectKernel(kernelParams);
+	if (!kernel)
+		return false;
+
+	// Rays without length or direction don't hit anything
+	const Bool noHits = (params._mode != PROJECTORMODE::CLOSESTPOINT && context._localRayLength <= 0.0) || (params._mode == PROJECTORMODE::PARALLEL && context._localRayDirection == Vector());
+
+	// The points of a chunk are gathered, so the same kernel as in Project() can process them. Once the arrays have grown to the chunk size, no more memory is allocated.
+	iferr (_chunkPositions.Resize(CHUNK_SIZE))
+		return false;
+
+	while (processed < count)
+	{
+		// Check if procesing should be cancelled, or if we're out of time
+		if (thread && thread->TestBreak())
+			break;
+		if (deadline > 0.0 && GeGetMilliSeconds() > deadline)
+			break;
+
+		const Int32 chunkCount = Min(CHUNK_SIZE, count - processed);
+		const Int32 *chunkIndices = indices + processed;
+		for (Int32 s = 0; s < chunkCount; ++s)
+			_chunkPositions[s] = padr[chunkIndices[s]];
+
+		if (!noHits && !(this->*kernel)(_chunkPositions.GetFirst(), chunkCount, kernelParams, context, nullptr))
+			return false;
+
+		// Displacements are stored in global space
+		for (Int32 s = 0; s < chunkCount; ++s)
+		{
+			const Int32 i = chunkIndices[s];
+			displacements[i] = context._opMg.sqmat * (_chunkPositions[s] - padr[i]);
+		}
+		processed += chunkCount;
+	}
+
+	return true;
+}
+
+Bool wsPointProjector::ApplyDisplacements(PointObject *op, const wsPointProjectorParams &params, const Vector *displacements)
+{
+	if (!op || !displacements)
+		return false;
+
+	const Int32 pointCount = op->GetPointCount();
+	Vector *padr = op->GetPointW();
+	if (!padr)
+		return false;
+
+	const Matrix opMg = op->GetMg();
+	const Matrix opMgI = ~opMg;
+
+	if (!SampleFalloff(op, params, opMg))
+		return false;
+
+	for (Int32 i = 0; i < pointCount; i++)
+	{
+		const Vector originalRayPosition = opMg * padr[i];
+		Vector rayPosition = originalRayPosition + displacements[i];
+		ApplyFalloffs(rayPosition, originalRayPosition, i, params);
+		padr[i] = opMgI * rayPosition;
+	}
+
+	return true;
+}
+
+Bool wsPointProjector::ProjectGeneric(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread)
+{
+	if (!_initialized || !_collider || !_collisionObject || !op)
+		return false;
+
+	// Get point count
+	const Int32 pointCount = op->GetPointCount();
+	if (pointCount == 0)
+		return false;
+
+	// Get writable point array
+	Vector *padr = op->GetPointW();
+	if (!padr)
+		return false;
+
+	// Get global Matrix of collision object and op, and their inversions
+	const Matrix collisionObjectMg = _collisionObject->GetMg();
+	const Matrix opMg = op->GetMg();
+	const Matrix collisionObjectMgI = ~collisionObjectMg;
+	const Matrix opMgI = ~opMg;
+
+	// Build the collision caches needed by the selected mode, and sample the falloff
+	if (!BuildCollisionCaches(params._mode, params._direction, params._sdfResolution, params._offset != 0.0, thread))
+		return false;
+	if (!SampleFalloff(op, params, opMg))
+		return false;
+
+	// If using parallel projection, calculate rayDirection now, as it's the same for all points
+	Vector rayDirection(DC);
+	if (params._mode == PROJECTORMODE::PARALLEL)
+		rayDirection = params._modifierMg.sqmat.v3;
+
+	// Calculate a ray length.
+	// The resulting length might be a bit too long, but with this we're on the safe side. No ray should ever be too short to reach the collision geometry.
+	const Float rayLength = (collisionObjectMg.off - opMg.off).GetLength() + _collisionObject->GetRad().GetSum()+ op->GetRad().GetSum();
+
+	// Iterate points
+	for (Int32 i = 0; i < pointCount; i++)
+	{
+		// Check if procesing should be cancelled
+		if (thread && !(i & 63) && thread->TestBreak())
+			break;
+
+		// Transform point position to global space
+		Vector rayPosition = opMg * padr[i];
+		const Vector originalRayPosition = rayPosition;
+
+		// Project point, cancel if critical error occurred
+		if (!ProjectPoint(rayPosition, rayDirection, rayLength, params, collisionObjectMg, collisionObjectMgI))
+			return false;
+
+		ApplyFalloffs(rayPosition, originalRayPosition, i, params);
 
 		// Transform point position back to op's local space
 		padr[i] = opMgI * rayPosition;
 	}
-	
+
 	return true;
 }
+
+Bool wsPointProjector::Project(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread, const wsPointSubsampler *subsampler)
+{
+	if (!op)
+		return false;
+	
+	// Get point count
+	const Int32 pointCount = op->GetPointCount();
+	if (pointCount == 0)
+		return false;
+	
+	// Get writable point array
+	Vector *padr = op->GetPointW();
+	if (!padr)
+		return false;
+
+	// Only project the samples, and interpolate the displacements of all other points
+	if (subsampler && subsampler->GetPointCount() == pointCount)
+	{
+		iferr (_displacements.Resize(pointCount))
+			return false;
+
+		ProjectionContext context;
+		if (!PrepareProjection(op, params, thread, context))
+			return false;
+
+		const maxon::BaseArray<Int32> &samples = subsampler->GetSamples();
+		Int32 processed = 0;
+		if (!ProjectDisplacements(op, params, context, samples.GetFirst(), (Int32)samples.GetCount(), _displacements.GetFirst(), processed, thread))
+			return false;
+
+		// Processing was cancelled. Leave the points alone, as the displacements are incomplete.
+		if (processed < (Int32)samples.GetCount())
+			return true;
+
+		subsampler->Interpolate(_displacements.GetFirst());
+		return ApplyDisplacements(op, params, _displacements.GetFirst());
+	}
+
+	ProjectionContext context;
+	if (!PrepareProjection(op, params, thread, context))
+		return false;
+
+	// The kernel is picked once, instead of checking the parameters for every point
+	const ProjectKernel kernel = GetProjectKernel(params);
+	if (!kernel)
+		return false;
+
+	if (!SampleFalloff(op, params, context._opMg))
+		return false;
+
+	// Rays without length or direction don't hit anything
+	if (params._mode != PROJECTORMODE::CLOSESTPOINT && context._localRayLength <= 0.0)
+		return true;
+	if (params._mode == PROJECTORMODE::PARALLEL && context._localRayDirection == Vector())
+		return true;
+
+	return (this->*kernel)(padr, pointCount, params, context, thread);
+}
@@ -5,60 +5,176 @@
 #include "c4d.h"
 #include "lib_collider.h"
 #include "c4d_falloffdata.h"
+#include "wsCollisionMesh.h"
+#include "wsSignedDistanceField.h"
+#include "wsPointSubsampler.h"
 
 
 /// Modes of projection
 enum class PROJECTORMODE
 {
-	NONE		= 0,
-	PARALLEL	= 1,
-	SPHERICAL	= 2
+	NONE			= 0,
+	PARALLEL		= 1,
+	SPHERICAL		= 2,
+	CLOSESTPOINT	= 3
 } MAXON_ENUM_LIST(PROJECTORMODE);
 
 
+/// Directions rays are shot in (parallel and spherical mode only)
+enum class PROJECTORDIRECTION
+{
+	FORWARD					= 0,	///< Only shoot forward along the ray direction
+	BOTH_NEAREST			= 1,	///< Shoot in both directions, the nearest hit on either side wins
+	BOTH_PREFERFORWARD	= 2		///< Shoot in both directions, a hit in forward direction always wins
+} MAXON_ENUM_LIST(PROJECTORDIRECTION);
+
+
 /// Parameters for projection
 struct wsPointProjectorParams
 {
 	Matrix        _modifierMg;										///< Global matrix of modifier
-	PROJECTORMODE _mode = PROJECTORMODE::NONE;		///< Projector mode (parallel or spherical)
+	PROJECTORMODE _mode = PROJECTORMODE::NONE;		///< Projector mode (none, parallel, spherical or closest point)
+	PROJECTORDIRECTION _direction = PROJECTORDIRECTION::FORWARD;	///< Ray direction (forward or bidirectional)
 	Float         _offset = 0.0_f;								///< Offset attribute
 	Float         _blend = 0.0_f;									///< Blend attribute
 	Bool          _geometryFalloffEnabled = true;	///< Geometry falloff enabled attribute
 	Float         _geometryFalloffDist = 0.0_f;		///< Geometry falloff distance attribute
+	Float         _maxSearchDist = 0.0_f;					///< Maximum search radius in closest point mode, 0.0 means unlimited
+	Int32         _sdfResolution = 0;							///< Resolution of the signed distance field in closest point mode, 0 means no field is used
 	Float32*			_weightMap = nullptr;						///< Ptr to weight map
 	C4D_Falloff  *_falloff = nullptr;							///< Ptr to falloff
+	const Float  *_falloffValues = nullptr;				///< Ptr to falloff values that have been sampled before, one for each point. Used instead of _falloff if set (e.g. when replaying a captured evaluation).
 	
 	/// Default constructor
 	wsPointProjectorParams() :
 		_mode(PROJECTORMODE::PARALLEL),
+		_direction(PROJECTORDIRECTION::FORWARD),
 		_offset(0.0),
 		_blend(0.0),
 		_geometryFalloffEnabled(false),
 		_geometryFalloffDist(0.0),
+		_maxSearchDist(0.0),
+		_sdfResolution(0),
 		_weightMap(nullptr),
-		_falloff(nullptr)
+		_falloff(nullptr),
+		_falloffValues(nullptr)
 	{ }
 	
 	/// Constructor with parameters
-	wsPointProjectorParams(const Matrix &modifierMg, PROJECTORMODE mode, Float offset, Float blend, Bool geometryFalloffEnabled, Float geometryFalloffDist, Float32 *weightMap = nullptr, C4D_Falloff *falloff = nullptr) :
+	wsPointProjectorParams(const Matrix &modifierMg, PROJECTORMODE mode, PROJECTORDIRECTION direction, Float offset, Float blend, Bool geometryFalloffEnabled, Float geometryFalloffDist, Float maxSearchDist = 0.0, Int32 sdfResolution = 0, Float32 *weightMap = nullptr, C4D_Falloff *falloff = nullptr) :
 		_modifierMg(modifierMg),
 		_mode(mode),
+		_direction(direction),
 		_offset(offset),
 		_blend(blend),
 		_geometryFalloffEnabled(geometryFalloffEnabled),
 		_geometryFalloffDist(geometryFalloffDist),
+		_maxSearchDist(maxSearchDist),
+		_sdfResolution(sdfResolution),
 		_weightMap(weightMap),
-		_falloff(falloff)
+		_falloff(falloff),
+		_falloffValues(nullptr)
 	{ }
+
+	/// @return True if a falloff or sampled falloff values are set
+	Bool HasFalloff() const
+	{
+		return _falloff || _falloffValues;
+	}
 };
 
+template <Int32 INDEX> struct wsProjectKernelTable;
+
 /// Handy class that does all the ray shooting and calculations for us
 class wsPointProjector
 {
+	template <Int32 INDEX> friend struct wsProjectKernelTable;
+
+public:
+	/// Values that are the same for all points of a projection, precalculated for better performance.
+	/// Calculated by PrepareProjection(), and valid as long as matrices, parameters and collision geometry don't change.
+	struct ProjectionContext
+	{
+		Matrix _collisionObjectMg;                 ///< Global matrix of collision geometry
+		Matrix _collisionObjectMgI;                ///< Inverted global matrix of collision geometry
+		Matrix _opMg;                              ///< Global matrix of projected object
+		Matrix _opMgI;                             ///< Inverted global matrix of projected object
+		Vector _rayDirection;                      ///< Ray direction in parallel mode
+		Float  _rayLength = 0.0;                   ///< Ray length (global space)
+
+		// Combined transforms, used by the projection kernels. They work in the collision object's local space.
+		Matrix _opToCollision;                     ///< Transforms from op's local space to the collision object's local space
+		Matrix _collisionToOp;                     ///< Transforms from the collision object's local space to op's local space
+		Vector _localRayDirection;                 ///< Ray direction in parallel mode, in the collision object's local space
+		Vector _localModifierPosition;             ///< Position of the modifier, in the collision object's local space
+		Float  _localRayLength = 0.0;              ///< Ray length, scaled to the collision object's local space
+		Float  _localMaxSearchDist = 0.0;          ///< Search radius in closest point mode, scaled to the collision object's local space
+		Float  _maxSearchDistSquared = 0.0;        ///< Squared search radius in closest point mode (global space)
+		Float  _geometryFalloffDistSquared = 0.0;  ///< Squared geometry falloff distance
+	};
+
 private:
 	AutoAlloc<GeRayCollider>  _collider;         ///< Used for shooting rays at the collision geometry
+	wsCollisionMesh           _mesh;             ///< Used for closest point queries, bidirectional rays and smooth normals on the collision geometry. Only built when needed.
+	wsSignedDistanceField     _sdf;              ///< Speeds up closest point queries on static collision geometry. Only built when needed.
 	PolygonObject            *_collisionObject;  ///< Collision geometry
 	Bool                      _initialized;      ///< Indicates if the class has been initialized
+	maxon::BaseArray<Vector>  _displacements;    ///< Displacement of each point, used when only a subset of points is projected
+	maxon::BaseArray<Float>   _falloffValues;    ///< Falloff value of each point, sampled once per projection. Kept to avoid allocations in the next projection.
+	maxon::BaseArray<Vector>  _chunkPositions;   ///< Positions of the points ProjectDisplacements() is currently working on
+
+	/// Projection kernel, specialized for one combination of parameters
+	using ProjectKernel = Bool (wsPointProjector::*)(Vector *padr, Int32 pointCount, const wsPointProjectorParams &params, const ProjectionContext &context, BaseThread *thread);
+
+	/// Shoot a ray at the collision geometry. Everything happens in the collision object's local space.
+	/// @param position Starting position of the ray
+	/// @param rayDirection Shooting direction of the ray
+	/// @param rayLength Length of the ray, in the collision object's local space
+	/// @param direction Shoot only forward, or in both directions along the ray. Bidirectional rays need the collision mesh to be built.
+	/// @param hitPosition Receives the hit position
+	/// @param hitNormal If set, receives the normalized surface normal at the hit position
+	/// @return True if something was hit, otherwise false
+	Bool IntersectRay(const Vector &position, const Vector &rayDirection, Float rayLength, PROJECTORDIRECTION direction, Vector &hitPosition, Vector *hitNormal);
+
+	/// Find the closest position on the collision geometry. Everything happens in the collision object's local space.
+	/// @note The collision mesh must have been built.
+	/// @param position Position of the point
+	/// @param localMaxDistance Search radius, scaled to the collision object's local space. Pass 0.0 for an unlimited search.
+	/// @param maxDistanceSquared Squared search radius in global space, the actual distance is checked against it. Pass 0.0 for an unlimited search.
+	/// @param collisionObjectMg Global Matrix of the collision geometry
+	/// @param hitPosition Receives the closest position
+	/// @param hitNormal If set, receives the interpolated surface normal at the closest position
+	/// @return True if something was found within the search radius, otherwise false
+	Bool FindClosest(const Vector &position, Float localMaxDistance, Float maxDistanceSquared, const Matrix &collisionObjectMg, Vector &hitPosition, Vector *hitNormal) const;
+
+	/// Project points, specialized for one combination of parameters, so the compiler can strip all checks for unused features from the loop.
+	/// Points are transformed straight into the collision object's local space, and back to op's local space with a single matrix each.
+	template <PROJECTORMODE MODE, Bool OFFSET, Bool BLEND, Bool GEOMETRYFALLOFF, Bool FALLOFF, Bool WEIGHTMAP>
+	Bool ProjectPoints(Vector *padr, Int32 pointCount, const wsPointProjectorParams &params, const ProjectionContext &context, BaseThread *thread);
+
+	/// Select the projection kernel that matches the parameters
+	/// @return The kernel, or nullptr if the mode is not supported
+	static ProjectKernel GetProjectKernel(const wsPointProjectorParams &params);
+
+	/// Project a single point, using the method selected in params. Used by ProjectGeneric(), all other projections use the kernels.
+	/// @param rayPosition Position of the point (global space). It also returns the resulting position.
+	/// @param rayDirection Ray direction (global space). In spherical mode, it is calculated from rayPosition.
+	/// @return False if there was a problem, otherwise true
+	Bool ProjectPoint(Vector &rayPosition, Vector &rayDirection, Float rayLength, const wsPointProjectorParams &params, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI);
+
+	/// Sample the falloff at the positions of all points, and store the values in _falloffValues
+	/// @param op The PointObject whose points should be sampled
+	/// @param params Parameters for projection. Nothing happens if no falloff is set.
+	/// @param opMg Global matrix of op
+	/// @return False if memory could not be allocated, otherwise true
+	Bool SampleFalloff(PointObject *op, const wsPointProjectorParams &params, const Matrix &opMg);
+
+	/// Blend a projected point back towards its original position, according to geometry falloff, falloff and weight map
+	/// @note SampleFalloff() must be called before.
+	/// @param rayPosition Projected position (global space). It also returns the resulting position.
+	/// @param originalRayPosition Original position (global space)
+	/// @param index Index of the point, for weight map lookup
+	void ApplyFalloffs(Vector &rayPosition, const Vector &originalRayPosition, Int32 index, const wsPointProjectorParams &params) const;
 	
 public:
 	/// Initialize class with the passed collisionObject
@@ -68,25 +184,108 @@ public:
 	/// @return True if initialization was successful, otherwise false
 	Bool Init(PolygonObject *collisionObject, Bool bForce = false);
 
+	/// Build the collision caches that are needed for a projection mode. They are only rebuilt if the geometry changed.
+	/// @note Init() must be called before. Project() calls this automatically, but calling it in advance (e.g. in a background thread) saves time later.
+	/// @param mode Projection mode
+	/// @param direction Ray direction, bidirectional rays need the collision mesh
+	/// @param sdfResolution Resolution of the signed distance field in closest point mode, 0 means no field is used
+	/// @param smoothNormals True if hit normals are needed (e.g. for the offset). They're interpolated from the vertex normals of the collision mesh.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem or processing was cancelled, otherwise true
+	Bool BuildCollisionCaches(PROJECTORMODE mode, PROJECTORDIRECTION direction, Int32 sdfResolution, Bool smoothNormals, BaseThread *thread = nullptr);
+
+	/// Finds out if the collision mesh is needed for a combination of parameters
+	/// @param smoothNormals True if hit normals are needed (e.g. for the offset)
+	/// @return True if BuildCollisionCaches() builds the collision mesh, at least its vertex normals
+	static Bool NeedsCollisionMesh(PROJECTORMODE mode, PROJECTORDIRECTION direction, Bool smoothNormals)
+	{
+		return NeedsCollisionHierarchy(mode, direction) || smoothNormals;
+	}
+
+	/// Finds out if the collision mesh is queried for a combination of parameters, so it needs its hierarchy
+	/// @return True if BuildCollisionCaches() builds the collision mesh with hierarchy
+	static Bool NeedsCollisionHierarchy(PROJECTORMODE mode, PROJECTORDIRECTION direction)
+	{
+		return mode == PROJECTORMODE::CLOSESTPOINT || direction != PROJECTORDIRECTION::FORWARD;
+	}
+
+	/// Calculate the projection context, and build the collision caches needed by the selected mode
+	/// @note Init() must be called before.
+	/// @param op The PointObject that should be projected. Caller owns the pointed object.
+	/// @param params Parameters for projection
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @param context Receives the context
+	/// @return False if there was a problem, otherwise true
+	Bool PrepareProjection(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread, ProjectionContext &context);
+
 	/// Project a single point on collision geometry
 	/// @note Init() must be called before.
 	/// @param position Starting position of the ray (global space). It also returns the resulting position.
 	/// @param rayDirection Shooting direction of the ray (global space)
-	/// @param rayLength Length of the ray
+	/// @param rayLength Length of the ray (global space)
 	/// @param collisionObjectMg Global Matrix of the collision geometry
 	/// @param collisionObjectMgI Inverted global matrix of the collision geometry
 	/// @param offset Offset of the resulting collision position along the ray direction
 	/// @param blend Blends between the original and the resulting position
-	/// @return False if there was a problem, otherwise true (even if the ray shot into the void, because that's not an error)
-	Bool ProjectPosition(Vector &position, const Vector &rayDirection, Float rayLength, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset = 0.0, Float blend = 0.0);
+	/// @param direction Shoot only forward, or in both directions along the ray. Bidirectional rays need the collision mesh to be built.
+	/// @return False if there was a problem, otherwise true (even if the ray shot into the void or has no direction, because that's not an error)
+	Bool ProjectPosition(Vector &position, const Vector &rayDirection, Float rayLength, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset = 0.0, Float blend = 0.0, PROJECTORDIRECTION direction = PROJECTORDIRECTION::FORWARD);
+
+	/// Move a single point to the closest position on the collision geometry
+	/// @note Init() must be called before, and the collision mesh must have been built.
+	/// @param position Position of the point (global space). It also returns the resulting position.
+	/// @param maxDistance Maximum search radius (global space), pass 0.0 for an unlimited search
+	/// @param collisionObjectMg Global Matrix of the collision geometry
+	/// @param collisionObjectMgI Inverted global matrix of the collision geometry
+	/// @param offset Offset of the resulting position along the interpolated surface normal
+	/// @param blend Blends between the original and the resulting position
+	/// @return False if there was a problem, otherwise true (even if nothing was found within the search radius, because that's not an error)
+	Bool ProjectPositionClosest(Vector &position, Float maxDistance, const Matrix &collisionObjectMg, const Matrix &collisionObjectMgI, Float offset = 0.0, Float blend = 0.0);
+
+	/// Project some points of a PointObject, and store how far they've moved. Falloffs are not applied.
+	/// @note PrepareProjection() must be called before. The context can be reused for several calls, e.g. when the points are projected in chunks.
+	/// @param op The PointObject whose points should be projected. It is not changed. Caller owns the pointed object.
+	/// @param params Parameters for projection
+	/// @param context The context returned by PrepareProjection()
+	/// @param indices Indices of the points that should be projected
+	/// @param count Number of indices
+	/// @param displacements Array with one element for each point of op. Receives the displacements (global space) of the projected points.
+	/// @param processed Receives the number of points that have been projected. Might be smaller than count if processing was cancelled, or ran out of time.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @param deadline Stop processing when GeGetMilliSeconds() passes this value. Pass 0.0 for no time limit.
+	/// @return False if there was a problem, otherwise true
+	Bool ProjectDisplacements(PointObject *op, const wsPointProjectorParams &params, const ProjectionContext &context, const Int32 *indices, Int32 count, Vector *displacements, Int32 &processed, BaseThread *thread = nullptr, Float64 deadline = 0.0);
+
+	/// Move all points of a PointObject by precalculated displacements, and apply geometry falloff, falloff and weight map
+	/// @param op The PointObject whose points should be moved. Caller owns the pointed object.
+	/// @param params Parameters for projection
+	/// @param displacements Displacement (global space) for each point of op
+	/// @return False if there was a problem, otherwise true
+	Bool ApplyDisplacements(PointObject *op, const wsPointProjectorParams &params, const Vector *displacements);
 
 	/// Project all points of a PointObject on collision geometry
 	/// @note Init() must be called before.
 	/// @param op The PointObject that should be projected. Caller owns the pointed object.
 	/// @param params Parameters for projection
 	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @param subsampler If set, only the points selected by the subsampler are projected, and all others are interpolated
+	/// @return False if there was a problem, otherwise true
+	Bool Project(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread = nullptr, const wsPointSubsampler *subsampler = nullptr);
+
+	/// @return The falloff values sampled by the last projection, one for each point, or nullptr if it had no falloff. Valid until the next projection.
+	const Float *GetFalloffValues() const
+	{
+		return _falloffValues.IsEmpty() ? nullptr : _falloffValues.GetFirst();
+	}
+
+	/// Project all points of a PointObject with a single loop that checks all parameters for every point, like before the specialized kernels existed.
+	/// Slower than Project(), only meant as a baseline for benchmarks (see ReplayEvaluationCapture()). The result is the same.
+	/// @note Init() must be called before.
+	/// @param op The PointObject that should be projected. Caller owns the pointed object.
+	/// @param params Parameters for projection
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
 	/// @return False if there was a problem, otherwise true
-	Bool Project(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread = nullptr);
+	Bool ProjectGeneric(PointObject *op, const wsPointProjectorParams &params, BaseThread *thread = nullptr);
 
 	/// Default constructor
 	wsPointProjector() : _collisionObject(nullptr), _initialized(false)
@@ -0,0 +1,270 @@
+#include "maxon/apibase.h"
+#include "wsPointSubsampler.h"
+
+
+static const Int32 GRID_FIT_ITERATIONS = 3;    ///< Number of attempts to fit the grid cell size to the requested number of samples
+static const Int64 GRID_CELL_BITS = 21;        ///< Number of bits per axis in a grid cell key
+static const Int64 GRID_CELL_MASK = (1LL << GRID_CELL_BITS) - 1;  ///< Largest grid coordinate along each axis
+
+
+/// Compute the integer grid coordinate of a position along one axis
+static inline Int64 GetCellCoordinate(Float value, Float origin, Float inverseCellSize)
+{
+	return ClampValue((Int64)((value - origin) * inverseCellSize), (Int64)0, GRID_CELL_MASK);
+}
+
+/// Pack three integer grid coordinates into a single key
+static inline Int64 GetCellKey(Int64 x, Int64 y, Int64 z)
+{
+	return (x << (GRID_CELL_BITS * 2)) | (y << GRID_CELL_BITS) | z;
+}
+
+
+Bool wsPointSubsampler::ResetNeighbors(Int32 pointCount)
+{
+	_samples.Flush();
+	iferr (_neighbors.Resize(pointCount))
+		return false;
+
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		Neighbors &neighbors = _neighbors[i];
+		for (Int32 k = 0; k < MAX_NEIGHBORS; ++k)
+		{
+			neighbors._sample[k] = NOTOK;
+			neighbors._weight[k] = 0.0f;
+		}
+	}
+	return true;
+}
+
+Bool wsPointSubsampler::InitSegments(Int32 pointCount, const Segment *segments, Int32 segmentCount, Int32 stride)
+{
+	if (!ResetNeighbors(pointCount))
+		return false;
+
+	stride = Max(stride, (Int32)1);
+
+	// Select samples in a range of points, and set up linear interpolation between them
+	auto SampleRange = [this, stride](Int32 start, Int32 count) -> Bool
+	{
+		const Int32 last = start + count - 1;
+		for (Int32 i = start; i <= last; ++i)
+		{
+			Neighbors &neighbors = _neighbors[i];
+			const Int32 left = start + ((i - start) / stride) * stride;
+
+			// Every stride-th point, and the last point of the range are samples
+			if (i == left || i == last)
+			{
+				iferr (_samples.Append(i))
+					return false;
+
+				neighbors._sample[0] = i;
+				neighbors._weight[0] = 1.0f;
+				continue;
+			}
+
+			const Int32 right = Min(left + stride, last);
+			const Float32 weight = (Float32)(i - left) / (Float32)(right - left);
+			neighbors._sample[0] = left;
+			neighbors._weight[0] = 1.0f - weight;
+			neighbors._sample[1] = right;
+			neighbors._weight[1] = weight;
+		}
+		return true;
+	};
+
+	Int32 start = 0;
+	if (segments)
+	{
+		for (Int32 s = 0; s < segmentCount && start < pointCount; ++s)
+		{
+			const Int32 count = Min(segments[s].cnt, pointCount - start);
+			if (count > 0 && !SampleRange(start, count))
+				return false;
+			start += count;
+		}
+	}
+
+	// Points that don't belong to a segment are treated like one more segment
+	if (start < pointCount && !SampleRange(start, pointCount - start))
+		return false;
+
+	return true;
+}
+
+Bool wsPointSubsampler::InitSpatial(const Vector *points, Int32 pointCount, Float fraction, Bool computeWeights)
+{
+	if (!points || !ResetNeighbors(computeWeights ? pointCount : 0))
+		return false;
+
+	if (pointCount == 0)
+		return true;
+
+	// Get bounding box of all points
+	Vector boxMin = points[0];
+	Vector boxMax = points[0];
+	for (Int32 i = 1; i < pointCount; ++i)
+	{
+		const Vector &p = points[i];
+		boxMin = Vector(Min(boxMin.x, p.x), Min(boxMin.y, p.y), Min(boxMin.z, p.z));
+		boxMax = Vector(Max(boxMax.x, p.x), Max(boxMax.y, p.y), Max(boxMax.z, p.z));
+	}
+	const Vector size = boxMax - boxMin;
+	const Float longest = Max(size.x, Max(size.y, size.z));
+	const Int32 targetSamples = Max((Int32)(pointCount * fraction), (Int32)1);
+
+	// All points in one spot, one sample is enough
+	if (longest <= 0.0)
+	{
+		iferr (_samples.Append(0))
+			return false;
+		for (Int32 i = 0; i < (Int32)_neighbors.GetCount(); ++i)
+		{
+			_neighbors[i]._sample[0] = 0;
+			_neighbors[i]._weight[0] = 1.0f;
+		}
+		return true;
+	}
+
+	// Points usually lie on a surface, so the number of occupied cells grows with the square of the inverse cell size.
+	// Start with an estimate based on the bounding box, then correct it a few times.
+	const Float surfaceEstimate = size.x * size.y + size.y * size.z + size.z * size.x;
+	Float cellSize = Max(Sqrt(Max(surfaceEstimate, longest * longest) / (Float)targetSamples), longest / (Float)GRID_CELL_MASK);
+	for (Int32 iteration = 0; iteration < GRID_FIT_ITERATIONS; ++iteration)
+	{
+		const Float inverseCellSize = 1.0 / cellSize;
+		_cells.Flush();
+		for (Int32 i = 0; i < pointCount; ++i)
+		{
+			const Vector &p = points[i];
+			const Int64 key = GetCellKey(GetCellCoordinate(p.x, boxMin.x, inverseCellSize), GetCellCoordinate(p.y, boxMin.y, inverseCellSize), GetCellCoordinate(p.z, boxMin.z, inverseCellSize));
+			Bool created = false;
+			iferr (_cells.InsertEntry(key, created))
+				return false;
+		}
+
+		const Float ratio = (Float)_cells.GetCount() / (Float)targetSamples;
+		if (ratio > 0.8 && ratio < 1.25)
+			break;
+
+		cellSize = Max(cellSize * ClampValue(Sqrt(ratio), 0.5, 2.0), longest / (Float)GRID_CELL_MASK);
+	}
+
+	// Select the point closest to the center of each cell as sample
+	const Float inverseCellSize = 1.0 / cellSize;
+	_cells.Flush();
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		const Vector &p = points[i];
+		const Int64 x = GetCellCoordinate(p.x, boxMin.x, inverseCellSize);
+		const Int64 y = GetCellCoordinate(p.y, boxMin.y, inverseCellSize);
+		const Int64 z = GetCellCoordinate(p.z, boxMin.z, inverseCellSize);
+		const Vector cellCenter = boxMin + Vector((Float)x + 0.5, (Float)y + 0.5, (Float)z + 0.5) * cellSize;
+
+		Bool created = false;
+		iferr (auto &entry = _cells.InsertEntry(GetCellKey(x, y, z), created))
+			return false;
+
+		if (created || (p - cellCenter).GetSquaredLength() < (points[entry.GetValue()] - cellCenter).GetSquaredLength())
+			entry.GetValue() = i;
+	}
+
+	for (const auto &entry : _cells)
+	{
+		iferr (_samples.Append(entry.GetValue()))
+			return false;
+	}
+
+	if (!computeWeights)
+		return true;
+
+	// Find the nearest samples in the surrounding cells for each point, and weight them by inverse squared distance
+	const Float epsilon = Sqr(cellSize * 0.001);
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		const Vector &p = points[i];
+		const Int64 x = GetCellCoordinate(p.x, boxMin.x, inverseCellSize);
+		const Int64 y = GetCellCoordinate(p.y, boxMin.y, inverseCellSize);
+		const Int64 z = GetCellCoordinate(p.z, boxMin.z, inverseCellSize);
+
+		Neighbors &neighbors = _neighbors[i];
+
+		// Samples interpolate from nobody but themselves
+		const Int32 *ownSample = _cells.FindValue(GetCellKey(x, y, z));
+		if (ownSample && *ownSample == i)
+		{
+			neighbors._sample[0] = i;
+			neighbors._weight[0] = 1.0f;
+			continue;
+		}
+
+		// Keep the nearest samples, sorted by distance
+		Float distances[MAX_NEIGHBORS];
+		Int32 found = 0;
+		for (Int64 dz = -1; dz <= 1; ++dz)
+		{
+			for (Int64 dy = -1; dy <= 1; ++dy)
+			{
+				for (Int64 dx = -1; dx <= 1; ++dx)
+				{
+					if (x + dx < 0 || y + dy < 0 || z + dz < 0)
+						continue;
+
+					const Int32 *sample = _cells.FindValue(GetCellKey(x + dx, y + dy, z + dz));
+					if (!sample)
+						continue;
+
+					const Float distance = (points[*sample] - p).GetSquaredLength();
+					Int32 slot = found < MAX_NEIGHBORS ? found++ : MAX_NEIGHBORS;
+					while (slot > 0 && distances[slot - 1] > distance)
+					{
+						if (slot < MAX_NEIGHBORS)
+						{
+							distances[slot] = distances[slot - 1];
+							neighbors._sample[slot] = neighbors._sample[slot - 1];
+						}
+						--slot;
+					}
+					if (slot < MAX_NEIGHBORS)
+					{
+						distances[slot] = distance;
+						neighbors._sample[slot] = *sample;
+					}
+				}
+			}
+		}
+
+		Float weightSum = 0.0;
+		for (Int32 k = 0; k < found; ++k)
+		{
+			distances[k] = 1.0 / (distances[k] + epsilon);
+			weightSum += distances[k];
+		}
+		for (Int32 k = 0; k < found; ++k)
+			neighbors._weight[k] = (Float32)(distances[k] / weightSum);
+	}
+
+	return true;
+}
+
+void wsPointSubsampler::Interpolate(Vector *displacements) const
+{
+	if (!displacements)
+		return;
+
+	for (Int32 i = 0; i < (Int32)_neighbors.GetCount(); ++i)
+	{
+		const Neighbors &neighbors = _neighbors[i];
+
+		// Samples keep their own displacement
+		if (neighbors._sample[0] == i)
+			continue;
+
+		Vector displacement;
+		for (Int32 k = 0; k < MAX_NEIGHBORS && neighbors._sample[k] != NOTOK; ++k)
+			displacement += displacements[neighbors._sample[k]] * neighbors._weight[k];
+		displacements[i] = displacement;
+	}
+}
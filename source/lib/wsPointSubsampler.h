@@ -0,0 +1,65 @@
+#ifndef WS_POINTSUBSAMPLER_H__
+#define WS_POINTSUBSAMPLER_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+#include "maxon/hashmap.h"
+
+
+/// Selects a subset of points ("samples") to project, and interpolates the displacements of all other points from their neighbouring samples.
+/// Used to speed up the projection in the editor.
+class wsPointSubsampler
+{
+private:
+	static const Int32 MAX_NEIGHBORS = 4;  ///< Maximum number of samples a point is interpolated from
+
+	/// The samples a point is interpolated from
+	struct Neighbors
+	{
+		Int32   _sample[MAX_NEIGHBORS];  ///< Point indices of samples, NOTOK for unused entries
+		Float32 _weight[MAX_NEIGHBORS];  ///< Normalized weights
+	};
+
+	maxon::BaseArray<Int32>         _samples;    ///< Indices of the points that should be projected
+	maxon::BaseArray<Neighbors>     _neighbors;  ///< Interpolation weights for each point
+	maxon::HashMap<Int64, Int32>    _cells;      ///< Grid cells and the sample in each cell, used by InitSpatial()
+
+	/// Allocate neighbor entries for all points, and mark all points as not interpolated
+	Bool ResetNeighbors(Int32 pointCount);
+
+public:
+	/// Select every Nth point of each segment, plus the first and last point. Points in between are interpolated linearly.
+	/// @param pointCount Number of points
+	/// @param segments Segments of a spline, pass nullptr if there are none
+	/// @param segmentCount Number of segments
+	/// @param stride Every stride-th point is selected
+	/// @return False if memory could not be allocated, otherwise true
+	Bool InitSegments(Int32 pointCount, const Segment *segments, Int32 segmentCount, Int32 stride);
+
+	/// Select a spatially stratified subset of points, one per cell of a grid. Other points are interpolated from the nearest samples in the neighbouring cells.
+	/// @param points Point positions
+	/// @param pointCount Number of points
+	/// @param fraction Approximate fraction of the points that should be selected
+	/// @param computeWeights If false, only the samples are selected, and Interpolate() can't be used. Saves time and memory.
+	/// @return False if memory could not be allocated, otherwise true
+	Bool InitSpatial(const Vector *points, Int32 pointCount, Float fraction, Bool computeWeights = true);
+
+	/// @return Number of points the subsampler was initialized for
+	Int32 GetPointCount() const
+	{
+		return (Int32)_neighbors.GetCount();
+	}
+
+	/// @return Indices of the points that should be projected
+	const maxon::BaseArray<Int32> &GetSamples() const
+	{
+		return _samples;
+	}
+
+	/// Interpolate displacements of all points that are not samples
+	/// @param displacements Displacement for each point. The values of the samples must be set, all others are overwritten.
+	void Interpolate(Vector *displacements) const;
+};
+
+#endif // WS_POINTSUBSAMPLER_H__
@@ -0,0 +1,182 @@
+#include "maxon/apibase.h"
+#include "wsProgressiveProjection.h"
+
+
+Bool wsProgressiveProjection::SelectLevel(PointObject *op, Int32 level, wsPointSubsampler &subsampler, Bool computeWeights, Bool &allPoints)
+{
+	// Each level has four times as many points as the previous one
+	Float fraction = _quality;
+	for (Int32 i = level; i < LEVEL_COUNT - 1; ++i)
+		fraction *= 0.25;
+
+	allPoints = fraction >= 1.0;
+	if (allPoints)
+		return true;
+
+	// Splines: Every Nth point of each segment
+	if (op->IsInstanceOf(Ospline))
+	{
+		SplineObject *splineOp = ToSpline(op);
+		return subsampler.InitSegments(op->GetPointCount(), splineOp->GetSegmentR(), splineOp->GetSegmentCount(), (Int32)Ceil(1.0 / fraction));
+	}
+
+	// Everything else: A spatially stratified subset
+	return subsampler.InitSpatial(op->GetPointR(), op->GetPointCount(), fraction, computeWeights);
+}
+
+Bool wsProgressiveProjection::StartLevel(PointObject *op)
+{
+	_levelSamples.Flush();
+	_cursor = 0;
+
+	Bool allPoints = false;
+	if (!SelectLevel(op, _level, _selector, false, allPoints))
+		return false;
+
+	// Points that have been projected in previous levels don't need to be projected again
+	if (allPoints)
+	{
+		for (Int32 i = 0; i < (Int32)_done.GetCount(); ++i)
+		{
+			if (!_done[i])
+			{
+				iferr (_levelSamples.Append(i))
+					return false;
+			}
+		}
+	}
+	else
+	{
+		for (const Int32 i : _selector.GetSamples())
+		{
+			if (!_done[i])
+			{
+				iferr (_levelSamples.Append(i))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+Bool wsProgressiveProjection::FinishLevel(PointObject *op)
+{
+	// Get interpolation weights for the completed level
+	Bool allPoints = false;
+	if (!SelectLevel(op, _level, _display, true, allPoints))
+		return false;
+
+	_interpolate = !allPoints;
+	_completedLevel = _level;
+	++_level;
+
+	if (_level < LEVEL_COUNT)
+		return StartLevel(op);
+
+	// Converged. The helper arrays are kept, they are reused when the projection starts over.
+	_levelSamples.Flush();
+	return true;
+}
+
+Bool wsProgressiveProjection::Update(wsPointProjector &projector, PointObject *op, const wsPointProjectorParams &params, UInt64 fingerprint, Float quality, Float64 timeSlice, BaseThread *thread)
+{
+	if (!op)
+		return false;
+
+	const Int32 pointCount = op->GetPointCount();
+	if (pointCount == 0)
+		return false;
+
+	// Start over if anything changed
+	if (fingerprint != _fingerprint || quality != _quality || pointCount != (Int32)_done.GetCount())
+	{
+		Restart();
+		iferr (_displacements.Resize(pointCount))
+			return false;
+		iferr (_done.Resize(pointCount))
+			return false;
+		for (Int32 i = 0; i < pointCount; ++i)
+			_done[i] = false;
+
+		_fingerprint = fingerprint;
+		_quality = quality;
+		if (!StartLevel(op))
+			return false;
+	}
+
+	// The context only depends on the input, which is covered by the fingerprint. Preparing it once per pass saves rebuilding and re-hashing for every chunk.
+	if (_level < LEVEL_COUNT && _contextProjector != &projector)
+	{
+		if (!projector.PrepareProjection(op, params, thread, _context))
+			return false;
+		_contextProjector = &projector;
+	}
+
+	const Float64 deadline = GeGetMilliSeconds() + timeSlice;
+	while (_level < LEVEL_COUNT)
+	{
+		// The first level is always completed, so there's something to show right away
+		const Float64 levelDeadline = (_completedLevel == NOTOK) ? 0.0 : deadline;
+
+		const Int32 remaining = (Int32)_levelSamples.GetCount() - _cursor;
+		if (remaining > 0)
+		{
+			Int32 processed = 0;
+			if (!projector.ProjectDisplacements(op, params, _context, _levelSamples.GetFirst() + _cursor, remaining, _displacements.GetFirst(), processed, thread, levelDeadline))
+				return false;
+
+			for (Int32 i = _cursor; i < _cursor + processed; ++i)
+				_done[_levelSamples[i]] = true;
+			_cursor += processed;
+
+			// Cancelled, or out of time
+			if (processed < remaining)
+				break;
+		}
+
+		if (!FinishLevel(op))
+			return false;
+
+		if (GeGetMilliSeconds() > deadline)
+			break;
+	}
+
+	// Nothing to show yet, leave the points alone
+	if (_completedLevel == NOTOK)
+		return true;
+
+	// All points have been projected, no interpolation needed
+	if (!_interpolate)
+		return projector.ApplyDisplacements(op, params, _displacements.GetFirst());
+
+	// Only show the completed level, never the partially refined one
+	iferr (_output.CopyFrom(_displacements))
+		return false;
+	_display.Interpolate(_output.GetFirst());
+	return projector.ApplyDisplacements(op, params, _output.GetFirst());
+}
+
+void wsProgressiveProjection::Restart()
+{
+	_displacements.Flush();
+	_done.Flush();
+	_levelSamples.Flush();
+	_output.Flush();
+	_contextProjector = nullptr;
+	_fingerprint = 0;
+	_quality = 1.0;
+	_level = 0;
+	_completedLevel = NOTOK;
+	_cursor = 0;
+	_interpolate = false;
+}
+
+void wsProgressiveProjection::Reset()
+{
+	_displacements.Reset();
+	_done.Reset();
+	_levelSamples.Reset();
+	_output.Reset();
+	Restart();
+}
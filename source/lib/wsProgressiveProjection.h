@@ -0,0 +1,79 @@
+#ifndef WS_PROGRESSIVEPROJECTION_H__
+#define WS_PROGRESSIVEPROJECTION_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+#include "wsPointProjector.h"
+#include "wsPointSubsampler.h"
+
+
+/// Projects the points of an object in several levels of increasing detail, spread over several evaluations.
+/// The first level is a small, spatially spread subset of the points, and each following level has four times as many points.
+/// Only completed levels are shown, all points in between are interpolated.
+class wsProgressiveProjection
+{
+private:
+	static const Int32 LEVEL_COUNT = 4;  ///< Number of levels, the last one has full detail
+
+	maxon::BaseArray<Vector>            _displacements;     ///< Displacement of each point, valid for all points that have been projected
+	maxon::BaseArray<Bool>              _done;              ///< Marks the points that have been projected
+	maxon::BaseArray<Int32>             _levelSamples;      ///< Points of the current level that need to be projected
+	maxon::BaseArray<Vector>            _output;            ///< Interpolated displacements of the last completed level
+	wsPointSubsampler                   _selector;          ///< Selects the points of the current level
+	wsPointSubsampler                   _display;           ///< Interpolation weights of the last completed level
+	wsPointProjector::ProjectionContext _context;           ///< Projection context, prepared once per refinement pass
+	const wsPointProjector             *_contextProjector;  ///< The projector _context has been prepared with, or nullptr. Only compared, never dereferenced.
+	UInt64                              _fingerprint;       ///< Fingerprint of the input the displacements have been computed for
+	Float                               _quality;           ///< Fraction of points projected in the last level
+	Int32                               _level;             ///< Level that is currently being refined, LEVEL_COUNT if converged
+	Int32                               _completedLevel;    ///< Last completed level, or NOTOK
+	Int32                               _cursor;            ///< Number of points of the current level that have been projected
+	Bool                                _interpolate;       ///< Indicates if the last completed level needs interpolation
+
+	/// Select the points of a level
+	/// @param op The projected object
+	/// @param level The level
+	/// @param subsampler Receives the selection
+	/// @param computeWeights Also compute interpolation weights
+	/// @param allPoints Receives true if the level contains all points. In that case, subsampler is not initialized.
+	/// @return False if there was a problem, otherwise true
+	Bool SelectLevel(PointObject *op, Int32 level, wsPointSubsampler &subsampler, Bool computeWeights, Bool &allPoints);
+
+	/// Select the points of the current level that still need to be projected
+	Bool StartLevel(PointObject *op);
+
+	/// Make the current level the one that is shown, and start the next one
+	Bool FinishLevel(PointObject *op);
+
+	/// Start over with the next Update() call, but keep the memory for reuse
+	void Restart();
+
+public:
+	/// Continue the projection, and move the points of op to the result of the last completed level.
+	/// If the input changed since the last call, everything starts over. The first level is always completed, all others are only worked on until the time slice is used up.
+	/// @param projector An initialized wsPointProjector
+	/// @param op The PointObject that should be projected. Caller owns the pointed object.
+	/// @param params Parameters for projection
+	/// @param fingerprint Fingerprint of everything that influences the projection (points, matrices, parameters, collision geometry)
+	/// @param quality Fraction of points that should be projected in the last level, the rest is interpolated
+	/// @param timeSlice Maximum time in milliseconds that should be spent on levels after the first one
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem, otherwise true
+	Bool Update(wsPointProjector &projector, PointObject *op, const wsPointProjectorParams &params, UInt64 fingerprint, Float quality, Float64 timeSlice, BaseThread *thread = nullptr);
+
+	/// @return True if a projection has been started, and there are levels left to refine
+	Bool IsRefining() const
+	{
+		return !_done.IsEmpty() && _level < LEVEL_COUNT;
+	}
+
+	/// Free all data, and start over with the next Update() call
+	void Reset();
+
+	/// Default constructor
+	wsProgressiveProjection() : _contextProjector(nullptr), _fingerprint(0), _quality(1.0), _level(0), _completedLevel(NOTOK), _cursor(0), _interpolate(false)
+	{ }
+};
+
+#endif // WS_PROGRESSIVEPROJECTION_H__
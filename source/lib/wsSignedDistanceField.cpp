@@ -0,0 +1,289 @@
+#include "maxon/apibase.h"
+#include "wsSignedDistanceField.h"
+
+
+static const Int32 SDF_BRICK_SIZE = 8;                                                ///< Number of fine cells along each axis of a brick
+static const Int32 SDF_BRICK_NODES = SDF_BRICK_SIZE + 1;                              ///< Number of nodes along each axis of a brick
+static const Int32 SDF_BRICK_SAMPLES = SDF_BRICK_NODES * SDF_BRICK_NODES * SDF_BRICK_NODES;  ///< Number of nodes in a brick
+static const Int32 SDF_MAX_STEPS = 4;                                                 ///< Maximum number of gradient steps in GetClosestPoint()
+static const Int SDF_MAX_COARSE_NODES = 1 << 24;                                      ///< Refuse to build absurdly large fields
+static const Float SDF_DOMAIN_PADDING = 0.25;                                         ///< Padding around the mesh bounding box, relative to its longest axis
+static const Float SDF_SQRT3 = 1.7320508075688772;                                   ///< Ratio between the diagonal and the edge length of a cube
+
+
+/// Compute signed distance and gradient of a position to a mesh
+/// @param searchRadius Search radius for the closest point query. If nothing is found in it, the search is repeated without limit.
+static Bool ComputeSample(const wsCollisionMesh &mesh, const Vector &position, Float searchRadius, Float32 &distance, Vector32 &gradient)
+{
+	wsCollisionMeshHit hit;
+	if (!mesh.GetClosestPoint(position, searchRadius, hit))
+	{
+		if (searchRadius <= 0.0 || !mesh.GetClosestPoint(position, 0.0, hit))
+			return false;
+	}
+
+	// Points on the back side of the surface get a negative distance
+	const Vector normal = mesh.GetInterpolatedNormal(hit);
+	const Vector delta = position - hit._position;
+	const Float sign = Dot(delta, normal) < 0.0 ? -1.0 : 1.0;
+
+	distance = (Float32)(hit._distance * sign);
+	gradient = Vector32(hit._distance > 0.0 ? delta * (sign / hit._distance) : normal);
+	return true;
+}
+
+
+Bool wsSignedDistanceField::Init(const wsCollisionMesh &mesh, Int32 resolution, BaseThread *thread)
+{
+	if (!mesh.HasHierarchy() || resolution < 1)
+	{
+		Reset();
+		return false;
+	}
+
+	// Nothing to do if neither geometry nor resolution changed
+	if (_initialized && mesh.GetFingerprint() == _fingerprint && resolution == _resolution)
+		return true;
+
+	Reset();
+
+	Vector boxMin, boxMax;
+	if (!mesh.GetBoundingBox(boxMin, boxMax))
+		return false;
+
+	const Vector extent = boxMax - boxMin;
+	const Float longest = Max(extent.x, Max(extent.y, extent.z));
+	if (longest <= 0.0)
+		return false;
+
+	// Set up the domain. It's a bit larger than the mesh, so points slightly off the surface still get a tight search radius.
+	const Float padding = longest * SDF_DOMAIN_PADDING;
+	_voxelSize = longest / (Float)resolution;
+	_cellSize = _voxelSize * SDF_BRICK_SIZE;
+	_origin = boxMin - Vector(padding);
+	const Vector domainSize = extent + Vector(padding * 2.0);
+	for (Int32 axis = 0; axis < 3; ++axis)
+		_cells[axis] = Max(1, (Int32)Ceil(domainSize[axis] / _cellSize));
+
+	const Int nodesX = _cells[0] + 1;
+	const Int nodesY = _cells[1] + 1;
+	const Int nodesZ = _cells[2] + 1;
+	if (nodesX * nodesY * nodesZ > SDF_MAX_COARSE_NODES)
+	{
+		Reset();
+		return false;
+	}
+
+	// Sample the coarse grid
+	iferr (_coarseSamples.Resize(nodesX * nodesY * nodesZ))
+	{
+		Reset();
+		return false;
+	}
+	for (Int z = 0; z < nodesZ; ++z)
+	{
+		if (thread && thread->TestBreak())
+		{
+			Reset();
+			return false;
+		}
+
+		for (Int y = 0; y < nodesY; ++y)
+		{
+			for (Int x = 0; x < nodesX; ++x)
+			{
+				GridSample &sample = _coarseSamples[(z * nodesY + y) * nodesX + x];
+				if (!ComputeSample(mesh, _origin + Vector((Float)x, (Float)y, (Float)z) * _cellSize, 0.0, sample._distance, sample._gradient))
+				{
+					Reset();
+					return false;
+				}
+			}
+		}
+	}
+
+	// Distance is 1-Lipschitz, so the surface can only run through cells that have a corner closer to it than the cell diagonal
+	const Float cellDiagonal = _cellSize * SDF_SQRT3;
+	iferr (_brickIndex.Resize((Int)_cells[0] * _cells[1] * _cells[2]))
+	{
+		Reset();
+		return false;
+	}
+
+	Int32 brickCount = 0;
+	for (Int32 cz = 0; cz < _cells[2]; ++cz)
+	{
+		for (Int32 cy = 0; cy < _cells[1]; ++cy)
+		{
+			for (Int32 cx = 0; cx < _cells[0]; ++cx)
+			{
+				Float minDistance = maxon::LIMIT<Float>::MAX;
+				for (Int32 corner = 0; corner < 8; ++corner)
+				{
+					const Int nodeIndex = ((cz + ((corner >> 2) & 1)) * nodesY + (cy + ((corner >> 1) & 1))) * nodesX + (cx + (corner & 1));
+					minDistance = Min(minDistance, (Float)Abs(_coarseSamples[nodeIndex]._distance));
+				}
+				_brickIndex[((Int)cz * _cells[1] + cy) * _cells[0] + cx] = (minDistance < cellDiagonal) ? brickCount++ : NOTOK;
+			}
+		}
+	}
+
+	// Sample the fine bricks. All their nodes are within two cell diagonals of the surface, which makes a good search radius.
+	iferr (_brickSamples.Resize((Int)brickCount * SDF_BRICK_SAMPLES))
+	{
+		Reset();
+		return false;
+	}
+	for (Int32 cz = 0; cz < _cells[2]; ++cz)
+	{
+		for (Int32 cy = 0; cy < _cells[1]; ++cy)
+		{
+			if (thread && thread->TestBreak())
+			{
+				Reset();
+				return false;
+			}
+
+			for (Int32 cx = 0; cx < _cells[0]; ++cx)
+			{
+				const Int32 brick = _brickIndex[((Int)cz * _cells[1] + cy) * _cells[0] + cx];
+				if (brick == NOTOK)
+					continue;
+
+				const Vector cellOrigin = _origin + Vector((Float)cx, (Float)cy, (Float)cz) * _cellSize;
+				GridSample *samples = &_brickSamples[(Int)brick * SDF_BRICK_SAMPLES];
+				for (Int32 z = 0; z < SDF_BRICK_NODES; ++z)
+				{
+					for (Int32 y = 0; y < SDF_BRICK_NODES; ++y)
+					{
+						for (Int32 x = 0; x < SDF_BRICK_NODES; ++x)
+						{
+							GridSample &sample = samples[(z * SDF_BRICK_NODES + y) * SDF_BRICK_NODES + x];
+							if (!ComputeSample(mesh, cellOrigin + Vector((Float)x, (Float)y, (Float)z) * _voxelSize, cellDiagonal * 2.0, sample._distance, sample._gradient))
+							{
+								Reset();
+								return false;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	_resolution = resolution;
+	_fingerprint = mesh.GetFingerprint();
+	_initialized = true;
+	return true;
+}
+
+void wsSignedDistanceField::Reset()
+{
+	_coarseSamples.Reset();
+	_brickIndex.Reset();
+	_brickSamples.Reset();
+	_voxelSize = 0.0;
+	_cellSize = 0.0;
+	_cells[0] = _cells[1] = _cells[2] = 0;
+	_resolution = 0;
+	_fingerprint = 0;
+	_initialized = false;
+}
+
+Bool wsSignedDistanceField::Sample(const Vector &position, Float &distance, Vector &gradient, Float &error) const
+{
+	if (!_initialized)
+		return false;
+
+	const Vector local = (position - _origin) / _cellSize;
+	if (local.x < 0.0 || local.y < 0.0 || local.z < 0.0 || local.x > _cells[0] || local.y > _cells[1] || local.z > _cells[2])
+		return false;
+
+	const Int32 cx = Min((Int32)local.x, _cells[0] - 1);
+	const Int32 cy = Min((Int32)local.y, _cells[1] - 1);
+	const Int32 cz = Min((Int32)local.z, _cells[2] - 1);
+	const Vector cellPosition(local.x - cx, local.y - cy, local.z - cz);
+
+	// Trilinear interpolation of the 8 nodes around a position
+	auto Interpolate = [&distance, &gradient](const GridSample *base, Int strideY, Int strideZ, const Vector &t)
+	{
+		distance = 0.0;
+		gradient = Vector();
+		for (Int32 corner = 0; corner < 8; ++corner)
+		{
+			const Int32 dx = corner & 1;
+			const Int32 dy = (corner >> 1) & 1;
+			const Int32 dz = (corner >> 2) & 1;
+			const Float weight = (dx ? t.x : 1.0 - t.x) * (dy ? t.y : 1.0 - t.y) * (dz ? t.z : 1.0 - t.z);
+			const GridSample &sample = base[dx + dy * strideY + dz * strideZ];
+			distance += sample._distance * weight;
+			gradient += Vector(sample._gradient) * weight;
+		}
+	};
+
+	const Int32 brick = _brickIndex[((Int)cz * _cells[1] + cy) * _cells[0] + cx];
+	if (brick != NOTOK)
+	{
+		const Vector fine = cellPosition * (Float)SDF_BRICK_SIZE;
+		const Int32 x = Min((Int32)fine.x, SDF_BRICK_SIZE - 1);
+		const Int32 y = Min((Int32)fine.y, SDF_BRICK_SIZE - 1);
+		const Int32 z = Min((Int32)fine.z, SDF_BRICK_SIZE - 1);
+		const GridSample *base = &_brickSamples[(Int)brick * SDF_BRICK_SAMPLES + (z * SDF_BRICK_NODES + y) * SDF_BRICK_NODES + x];
+		Interpolate(base, SDF_BRICK_NODES, SDF_BRICK_NODES * SDF_BRICK_NODES, Vector(fine.x - x, fine.y - y, fine.z - z));
+		error = _voxelSize * SDF_SQRT3;
+	}
+	else
+	{
+		const Int nodesX = _cells[0] + 1;
+		const Int nodesY = _cells[1] + 1;
+		const GridSample *base = &_coarseSamples[((Int)cz * nodesY + cy) * nodesX + cx];
+		Interpolate(base, nodesX, nodesX * nodesY, cellPosition);
+		error = _cellSize * SDF_SQRT3;
+	}
+
+	return true;
+}
+
+Bool wsSignedDistanceField::GetClosestPoint(const wsCollisionMesh &mesh, const Vector &position, Float maxDistance, wsCollisionMeshHit &hit) const
+{
+	Float distance, error;
+	Vector gradient;
+
+	// Outside of the domain, there's nothing the field can help with
+	if (!Sample(position, distance, gradient, error))
+		return mesh.GetClosestPoint(position, maxDistance, hit);
+
+	// The surface is definitely out of reach
+	if (maxDistance > 0.0 && Abs(distance) - error > maxDistance)
+		return false;
+
+	// The interpolated distance is off by less than the cell diagonal, so the surface is within this radius
+	Float searchRadius = Abs(distance) + error;
+
+	// Walk towards the surface. Once inside the fine bricks, the error gets a lot smaller, and so does the search radius.
+	Vector walkPosition = position;
+	for (Int32 step = 0; step < SDF_MAX_STEPS && Abs(distance) > error; ++step)
+	{
+		const Float gradientLength = gradient.GetLength();
+		if (gradientLength == 0.0)
+			break;
+
+		walkPosition -= gradient * (distance / gradientLength);
+		if (!Sample(walkPosition, distance, gradient, error))
+			break;
+
+		searchRadius = Min(searchRadius, (walkPosition - position).GetLength() + Abs(distance) + error);
+	}
+
+	// Account for the limited precision of the stored samples
+	searchRadius += _voxelSize * 0.01;
+	if (maxDistance > 0.0 && searchRadius >= maxDistance)
+		return mesh.GetClosestPoint(position, maxDistance, hit);
+
+	// Exact refinement on the mesh, with the tight search radius most of the hierarchy is skipped
+	if (mesh.GetClosestPoint(position, searchRadius, hit))
+		return true;
+
+	// The field wasn't accurate enough (e.g. on open meshes with ambiguous signs), fall back to the full search
+	return mesh.GetClosestPoint(position, maxDistance, hit);
+}
@@ -0,0 +1,75 @@
+#ifndef WS_SIGNEDDISTANCEFIELD_H__
+#define WS_SIGNEDDISTANCEFIELD_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+#include "wsCollisionMesh.h"
+
+
+/// Sparse voxel grid of signed distances (and their gradients) to the surface of a wsCollisionMesh.
+/// A coarse dense grid covers the whole domain, and fine bricks are only stored in the cells the surface runs through.
+/// It is used to get a tight search radius for closest point queries, which makes them a lot cheaper.
+/// @note All positions are in the local space of the mesh.
+class wsSignedDistanceField
+{
+private:
+	/// A grid node
+	struct GridSample
+	{
+		Float32  _distance;  ///< Signed distance, negative below the surface
+		Vector32 _gradient;  ///< Normalized gradient of the distance
+	};
+
+	maxon::BaseArray<GridSample>  _coarseSamples;  ///< Nodes of the coarse grid
+	maxon::BaseArray<Int32>       _brickIndex;     ///< Index of the fine brick for each coarse cell, or NOTOK if the cell has no brick
+	maxon::BaseArray<GridSample>  _brickSamples;   ///< Nodes of all fine bricks
+	Vector                        _origin;         ///< Minimum corner of the domain
+	Float                         _voxelSize;      ///< Edge length of a fine cell
+	Float                         _cellSize;       ///< Edge length of a coarse cell
+	Int32                         _cells[3];       ///< Number of coarse cells along each axis
+	Int32                         _resolution;     ///< Number of fine cells along the longest axis of the mesh
+	UInt64                        _fingerprint;    ///< Fingerprint of the mesh the field was built from
+	Bool                          _initialized;    ///< Indicates if the field has been built
+
+	/// Look up distance and gradient at a position with trilinear interpolation
+	/// @param position Lookup position
+	/// @param distance Receives the signed distance
+	/// @param gradient Receives the gradient (not normalized)
+	/// @param error Receives the maximum error of the returned distance
+	/// @return False if position is outside the domain, otherwise true
+	Bool Sample(const Vector &position, Float &distance, Vector &gradient, Float &error) const;
+
+public:
+	/// Build the field from a mesh
+	/// @note This does nothing if neither the mesh geometry nor the resolution changed since the last call.
+	/// @param mesh The mesh to build from, must be initialized with hierarchy
+	/// @param resolution Number of fine cells along the longest axis of the mesh
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return True if building was successful, otherwise false
+	Bool Init(const wsCollisionMesh &mesh, Int32 resolution, BaseThread *thread = nullptr);
+
+	/// Free all data
+	void Reset();
+
+	/// @return True if the field has been built successfully
+	Bool IsInitialized() const
+	{
+		return _initialized;
+	}
+
+	/// Find the closest point on the mesh surface.
+	/// The position is moved towards the surface with a few gradient steps through the field, then the exact point is searched on the mesh within the tight radius found that way.
+	/// @param mesh The mesh the field was built from
+	/// @param position Query position
+	/// @param maxDistance Only points closer than this are found. Pass 0.0 for an unlimited search radius.
+	/// @param hit Receives the result
+	/// @return True if a point was found, otherwise false
+	Bool GetClosestPoint(const wsCollisionMesh &mesh, const Vector &position, Float maxDistance, wsCollisionMeshHit &hit) const;
+
+	/// Default constructor
+	wsSignedDistanceField() : _voxelSize(0.0), _cellSize(0.0), _cells{ 0, 0, 0 }, _resolution(0), _fingerprint(0), _initialized(false)
+	{ }
+};
+
+#endif // WS_SIGNEDDISTANCEFIELD_H__
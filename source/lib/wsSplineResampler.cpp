@@ -0,0 +1,212 @@
+#include "maxon/apibase.h"
+#include "wsSplineResampler.h"
+
+
+/// Distance between a position and a line segment
+static inline Float DistanceToSegment(const Vector &p, const Vector &a, const Vector &b)
+{
+	const Vector ab = b - a;
+	const Float lengthSquared = ab.GetSquaredLength();
+	if (lengthSquared == 0.0)
+		return (p - a).GetLength();
+
+	const Float t = ClampValue(Dot(p - a, ab) / lengthSquared, 0.0, 1.0);
+	return (p - (a + ab * t)).GetLength();
+}
+
+
+Bool wsSplineResampler::ProjectBatch(wsPointProjector &projector, const Matrix &opMg, const wsPointProjectorParams &params, const Vector *positions, const Float32 *weights, Int32 count, BaseThread *thread)
+{
+	if (count == 0)
+		return true;
+
+	if (!_points || !_points->ResizeObject(count, 0))
+		return false;
+
+	CopyMem(positions, _points->GetPointW(), count * sizeof(Vector));
+	_points->SetMg(opMg);
+	_points->Message(MSG_UPDATE);
+
+	// The weight map belongs to the original points, so the interpolated values are used instead.
+	// The same goes for sampled falloff values, the falloff is sampled again at the batch positions.
+	wsPointProjectorParams batchParams = params;
+	batchParams._weightMap = const_cast<Float32*>(weights);
+	batchParams._falloffValues = nullptr;
+	return projector.Project(_points, batchParams, thread);
+}
+
+Bool wsSplineResampler::Project(SplineObject *op, wsPointProjector &projector, const wsPointProjectorParams &params, Float tolerance, Int32 maxDepth, BaseThread *thread)
+{
+	if (!op)
+		return false;
+
+	const Int32 pointCount = op->GetPointCount();
+	const Vector *padr = op->GetPointR();
+	if (pointCount == 0 || !padr)
+		return true;
+
+	// Midpoints are taken on the straight lines between the points
+	if (op->GetInterpolationType() != SPLINETYPE::LINEAR)
+		return false;
+
+	const Matrix opMg = op->GetMg();
+
+	// Get segments. A spline without segments has a single one.
+	const Segment *segments = op->GetSegmentR();
+	Int32 segmentCount = op->GetSegmentCount();
+	const Bool hasSegments = segments && segmentCount > 0;
+	if (!hasSegments)
+		segmentCount = 1;
+
+	_vertices.Flush();
+	_intervals.Flush();
+	iferr (_firsts.Resize(segmentCount))
+		return false;
+	iferr (_counts.Resize(segmentCount))
+		return false;
+	iferr (_closed.Resize(segmentCount))
+		return false;
+
+	// Create a vertex for each point, on the unprojected spline. Closed segments get an extra vertex at the end, a copy of the first one.
+	Int32 start = 0;
+	for (Int32 s = 0; s < segmentCount; ++s)
+	{
+		const Int32 count = hasSegments ? segments[s].cnt : pointCount;
+		const Bool closed = hasSegments ? segments[s].closed : op->IsClosed();
+		if (start + count > pointCount)
+			return false;
+
+		_firsts[s] = (Int32)_vertices.GetCount();
+		_counts[s] = count;
+		_closed[s] = closed;
+		const Int32 vertexCount = (closed && count > 1) ? count + 1 : count;
+		for (Int32 i = 0; i < vertexCount; ++i)
+		{
+			const Int32 pointIndex = start + (i % count);
+			Vertex vertex;
+			vertex._original = padr[pointIndex];
+			vertex._weight = params._weightMap ? params._weightMap[pointIndex] : 1.0f;
+			vertex._next = i < vertexCount - 1 ? (Int32)_vertices.GetCount() + 1 : NOTOK;
+			iferr (_vertices.Append(vertex))
+				return false;
+
+			if (i < vertexCount - 1 && maxDepth > 0)
+			{
+				iferr (_intervals.Append(Interval{ (Int32)_vertices.GetCount() - 1, 0 }))
+					return false;
+			}
+		}
+		start += count;
+	}
+
+	// Project the spline's own points
+	const Int32 vertexCount = (Int32)_vertices.GetCount();
+	iferr (_positions.Resize(vertexCount))
+		return false;
+	iferr (_weights.Resize(vertexCount))
+		return false;
+	for (Int32 i = 0; i < vertexCount; ++i)
+	{
+		_positions[i] = _vertices[i]._original;
+		_weights[i] = _vertices[i]._weight;
+	}
+	if (!ProjectBatch(projector, opMg, params, _positions.GetFirst(), params._weightMap ? _weights.GetFirst() : nullptr, vertexCount, thread))
+		return false;
+	for (Int32 i = 0; i < vertexCount; ++i)
+		_vertices[i]._projected = _points->GetPointR()[i];
+
+	// Subdivide, one level per pass. All midpoints of a pass are projected in one batch.
+	while (!_intervals.IsEmpty())
+	{
+		// The spline must not come out half processed
+		if (thread && thread->TestBreak())
+			return false;
+
+		// Midpoints on the unprojected spline
+		const Int32 intervalCount = (Int32)_intervals.GetCount();
+		iferr (_positions.Resize(intervalCount))
+			return false;
+		iferr (_weights.Resize(intervalCount))
+			return false;
+		for (Int32 k = 0; k < intervalCount; ++k)
+		{
+			const Vertex &a = _vertices[_intervals[k]._first];
+			const Vertex &b = _vertices[a._next];
+			_positions[k] = (a._original + b._original) * 0.5;
+			_weights[k] = (a._weight + b._weight) * 0.5f;
+		}
+
+		if (!ProjectBatch(projector, opMg, params, _positions.GetFirst(), params._weightMap ? _weights.GetFirst() : nullptr, intervalCount, thread))
+			return false;
+
+		// Insert the midpoints that deviate too much, and test both halves in the next pass
+		_next.Flush();
+		const Vector *projected = _points->GetPointR();
+		for (Int32 k = 0; k < intervalCount; ++k)
+		{
+			const Interval interval = _intervals[k];
+			const Int32 b = _vertices[interval._first]._next;
+			const Float deviation = DistanceToSegment(opMg.sqmat * projected[k], opMg.sqmat * _vertices[interval._first]._projected, opMg.sqmat * _vertices[b]._projected);
+			if (deviation <= tolerance)
+				continue;
+
+			Vertex vertex;
+			vertex._original = _positions[k];
+			vertex._projected = projected[k];
+			vertex._weight = _weights[k];
+			vertex._next = b;
+			const Int32 m = (Int32)_vertices.GetCount();
+			iferr (_vertices.Append(vertex))
+				return false;
+			_vertices[interval._first]._next = m;
+
+			if (interval._depth + 1 < maxDepth)
+			{
+				iferr (_next.Append(Interval{ interval._first, interval._depth + 1 }))
+					return false;
+				iferr (_next.Append(Interval{ m, interval._depth + 1 }))
+					return false;
+			}
+		}
+
+		iferr (_intervals.CopyFrom(_next))
+			return false;
+	}
+
+	// Count the vertices of each segment
+	Int32 newPointCount = 0;
+	for (Int32 s = 0; s < segmentCount; ++s)
+	{
+		Int32 count = 0;
+		for (Int32 v = _firsts[s]; v != NOTOK; v = _vertices[v]._next)
+			++count;
+
+		// The extra vertex at the end of closed segments is not written
+		if (_closed[s] && _counts[s] > 1)
+			--count;
+		_counts[s] = count;
+		newPointCount += count;
+	}
+
+	// Replace the spline's points. The segment array is reallocated, so the closure flags come from _closed.
+	if (!op->ResizeObject(newPointCount, hasSegments ? segmentCount : 0))
+		return false;
+
+	Vector *newPadr = op->GetPointW();
+	Segment *newSegments = op->GetSegmentW();
+	Int32 index = 0;
+	for (Int32 s = 0; s < segmentCount; ++s)
+	{
+		Int32 v = _firsts[s];
+		for (Int32 i = 0; i < _counts[s]; ++i, v = _vertices[v]._next)
+			newPadr[index++] = _vertices[v]._projected;
+
+		if (hasSegments && newSegments)
+		{
+			newSegments[s].cnt = _counts[s];
+			newSegments[s].closed = _closed[s];
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,60 @@
+#ifndef WS_SPLINERESAMPLER_H__
+#define WS_SPLINERESAMPLER_H__
+
+
+#include "c4d.h"
+#include "maxon/basearray.h"
+#include "wsPointProjector.h"
+
+
+/// Projects a linear spline, and adds points where the projected spline would cut through the collision geometry.
+/// First, the points of the spline are projected. Then, the midpoint of each segment is projected. If it deviates from the straight line between the projected ends by more than a tolerance, it is inserted, and both halves are tested the same way.
+/// This conforms to the surface with far fewer rays than a uniformly subdivided spline.
+/// Only linear splines are supported. Other interpolation types would lose their shape where nothing hits the surface, as the result is always linear.
+class wsSplineResampler
+{
+private:
+	/// A point of the resampled spline. The points of each segment form a linked list.
+	struct Vertex
+	{
+		Vector  _original;   ///< Position on the unprojected spline (op's local space)
+		Vector  _projected;  ///< Projected position (op's local space)
+		Float32 _weight;     ///< Weight map value, interpolated between the original points
+		Int32   _next;       ///< Index of the next vertex in the segment, or NOTOK
+	};
+
+	/// A part of a segment that is tested for subdivision
+	struct Interval
+	{
+		Int32 _first;  ///< Index of the vertex at the start of the interval. It ends at the next vertex.
+		Int32 _depth;  ///< Number of subdivisions that led to this interval
+	};
+
+	maxon::BaseArray<Vertex>    _vertices;   ///< All vertices
+	maxon::BaseArray<Int32>     _firsts;     ///< First vertex of each segment
+	maxon::BaseArray<Int32>     _counts;     ///< Number of vertices in each segment
+	maxon::BaseArray<Bool>      _closed;     ///< Indicates for each segment if it's closed
+	maxon::BaseArray<Interval>  _intervals;  ///< Intervals that are tested in the current pass
+	maxon::BaseArray<Interval>  _next;       ///< Intervals that are tested in the next pass
+	maxon::BaseArray<Vector>    _positions;  ///< Positions that are projected in the current pass, on the unprojected spline
+	maxon::BaseArray<Float32>   _weights;    ///< Weight map values of the positions that are projected in the current pass
+	AutoAlloc<PolygonObject>    _points;     ///< Positions that are projected in the current pass
+
+	/// Project a batch of positions, the results are stored in _points
+	/// @param positions The positions (op's local space)
+	/// @param weights Weight map values of the positions, or nullptr
+	Bool ProjectBatch(wsPointProjector &projector, const Matrix &opMg, const wsPointProjectorParams &params, const Vector *positions, const Float32 *weights, Int32 count, BaseThread *thread);
+
+public:
+	/// Project a linear spline adaptively. The spline's points are replaced by the resampled ones.
+	/// @param op The spline that should be projected, must be linear. Caller owns the pointed object.
+	/// @param projector An initialized projector
+	/// @param params Parameters for projection
+	/// @param tolerance Maximum distance (global space) between the projected midpoint of a segment and the straight line between its projected ends
+	/// @param maxDepth Maximum number of times a segment is subdivided
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem, op is not linear, or processing was cancelled, otherwise true
+	Bool Project(SplineObject *op, wsPointProjector &projector, const wsPointProjectorParams &params, Float tolerance, Int32 maxDepth, BaseThread *thread = nullptr);
+};
+
+#endif // WS_SPLINERESAMPLER_H__
@@ -0,0 +1,696 @@
+#include "maxon/apibase.h"
+#include "wsTiledCollisionMesh.h"
+#include "wsFunctions.h"
+
+
+static const Int32 TILES_MAGIC = 0x4D545357;      ///< "WSTM", identifies tile files
+static const Int32 TILES_VERSION = 2;             ///< Increase when the file layout changes
+static const Int64 TILES_INDEX_POSITION = 8;      ///< Position of the index offset in the file, right after magic and version
+static const Int64 TILES_ENTRY_SIZE = 68;         ///< Number of bytes of an index entry in the file
+
+
+/// Squared distance between a position and an axis aligned box. Returns 0.0 if the position is inside the box.
+static inline Float DistanceSquaredToBox(const Vector &p, const Vector &boxMin, const Vector &boxMax)
+{
+	Float result = 0.0;
+	if (p.x < boxMin.x)
+		result += Sqr(boxMin.x - p.x);
+	else if (p.x > boxMax.x)
+		result += Sqr(p.x - boxMax.x);
+	if (p.y < boxMin.y)
+		result += Sqr(boxMin.y - p.y);
+	else if (p.y > boxMax.y)
+		result += Sqr(p.y - boxMax.y);
+	if (p.z < boxMin.z)
+		result += Sqr(boxMin.z - p.z);
+	else if (p.z > boxMax.z)
+		result += Sqr(p.z - boxMax.z);
+	return result;
+}
+
+/// Intersect a line with an axis aligned box
+/// @param direction Direction of the line. Axes where it is zero are tested explicitly, multiplying by their infinite inverse would give NaN for an origin right on a box plane.
+/// @param inverseDirection Component-wise inverse of direction
+/// @param tNear Receives the parameter where the line enters the box
+/// @param tFar Receives the parameter where the line leaves the box
+/// @return False if the line misses the box, otherwise true
+static inline Bool IntersectBox(const Vector &origin, const Vector &direction, const Vector &inverseDirection, const Vector &boxMin, const Vector &boxMax, Float &tNear, Float &tFar)
+{
+	tNear = maxon::LIMIT<Float>::MIN;
+	tFar = maxon::LIMIT<Float>::MAX;
+	for (Int32 axis = 0; axis < 3; ++axis)
+	{
+		// A line parallel to the slab is either always inside of it, or never
+		if (direction[axis] == 0.0)
+		{
+			if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+				return false;
+			continue;
+		}
+
+		const Float t1 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+		const Float t2 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+		tNear = Max(tNear, Min(t1, t2));
+		tFar = Min(tFar, Max(t1, t2));
+	}
+	return tNear <= tFar;
+}
+
+
+Bool wsTiledCollisionMeshWriter::Open(const Filename &filename, Int32 maxPolygons)
+{
+	_tiles.Reset();
+	_maxPolygons = Max(maxPolygons, (Int32)1);
+	if (!_file || !_file->Open(filename, FILEOPEN::WRITE, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+		return false;
+
+	// Header. The position of the index is not known yet, it's written by Close().
+	return _file->WriteInt32(TILES_MAGIC) && _file->WriteInt32(TILES_VERSION) && _file->WriteInt64(0);
+}
+
+Bool wsTiledCollisionMeshWriter::WriteTile(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, BaseThread *thread)
+{
+	// Build the tile. It's freed again when it has been written.
+	wsCollisionMesh mesh;
+	if (!mesh.InitPart(polyObject, polygons, polygonCount, _cornerNormals.GetFirst(), thread))
+		return false;
+
+	wsCollisionTile tile;
+	if (!mesh.GetBoundingBox(tile._min, tile._max))
+		return false;
+	tile._offset = _file->GetPosition();
+	tile._memorySize = mesh.GetMemorySize();
+	tile._triangleCount = mesh.GetTriangleCount();
+
+	if (!mesh.Write(_file))
+		return false;
+
+	iferr (_tiles.Append(tile))
+		return false;
+
+	return true;
+}
+
+Bool wsTiledCollisionMeshWriter::AddGeometry(const PolygonObject *polyObject, BaseThread *thread)
+{
+	/// A range of _polygons that still needs to be split or written
+	struct Part
+	{
+		Int32 _start;
+		Int32 _count;
+	};
+
+	if (!_file || !polyObject)
+		return false;
+
+	const Int32 polyCount = polyObject->GetPolygonCount();
+	const Vector *padr = polyObject->GetPointR();
+	const CPolygon *vadr = polyObject->GetPolygonR();
+	if (polyCount == 0 || !padr || !vadr)
+		return false;
+
+	// Normals are computed once for the whole geometry, so they're continuous across tile borders
+	if (!wsCollisionMesh::GetCornerNormals(polyObject, _cornerNormals))
+		return false;
+
+	iferr (_centroids.Resize(polyCount))
+		return false;
+	iferr (_polygons.Resize(polyCount))
+		return false;
+	for (Int32 i = 0; i < polyCount; ++i)
+	{
+		const CPolygon &poly = vadr[i];
+		_centroids[i] = (padr[poly.a] + padr[poly.b] + padr[poly.c] + padr[poly.d]) * 0.25;
+		_polygons[i] = i;
+	}
+
+	maxon::BaseArray<Part> parts;
+	iferr (parts.Append(Part{ 0, polyCount }))
+		return false;
+
+	const Float maxValue = maxon::LIMIT<Float>::MAX;
+	const Float minValue = maxon::LIMIT<Float>::MIN;
+
+	Part part;
+	while (parts.Pop(&part))
+	{
+		if (thread && thread->TestBreak())
+			return false;
+
+		// Small enough for a tile
+		if (part._count <= _maxPolygons)
+		{
+			if (!WriteTile(polyObject, _polygons.GetFirst() + part._start, part._count, thread))
+				return false;
+			continue;
+		}
+
+		// Split along the axis with the largest centroid extent
+		Vector centroidMin(maxValue), centroidMax(minValue);
+		for (Int32 i = part._start; i < part._start + part._count; ++i)
+		{
+			const Vector &centroid = _centroids[_polygons[i]];
+			centroidMin = Vector(Min(centroidMin.x, centroid.x), Min(centroidMin.y, centroid.y), Min(centroidMin.z, centroid.z));
+			centroidMax = Vector(Max(centroidMax.x, centroid.x), Max(centroidMax.y, centroid.y), Max(centroidMax.z, centroid.z));
+		}
+		const Vector centroidSize = centroidMax - centroidMin;
+		Int32 axis = 0;
+		if (centroidSize.y > centroidSize[axis])
+			axis = 1;
+		if (centroidSize.z > centroidSize[axis])
+			axis = 2;
+
+		// Partition polygons at the center, so tiles form a regular grid where the geometry is evenly spread
+		const Float center = centroidMin[axis] + centroidSize[axis] * 0.5;
+		Int32 left = part._start;
+		Int32 right = part._start + part._count - 1;
+		while (left <= right)
+		{
+			if (_centroids[_polygons[left]][axis] < center)
+			{
+				++left;
+			}
+			else
+			{
+				const Int32 tmp = _polygons[left];
+				_polygons[left] = _polygons[right];
+				_polygons[right] = tmp;
+				--right;
+			}
+		}
+
+		// All polygons on one side, e.g. if their centroids are in the same spot. Split by count instead.
+		Int32 leftCount = left - part._start;
+		if (leftCount == 0 || leftCount == part._count)
+			leftCount = part._count / 2;
+
+		iferr (parts.Append(Part{ part._start, leftCount }))
+			return false;
+		iferr (parts.Append(Part{ part._start + leftCount, part._count - leftCount }))
+			return false;
+	}
+
+	return true;
+}
+
+Bool wsTiledCollisionMeshWriter::AddScene(const Filename &sceneFile, BaseThread *thread)
+{
+	BaseDocument *doc = LoadDocument(sceneFile, SCENEFILTER::OBJECTS, thread);
+	if (!doc)
+		return false;
+
+	Bool success = true;
+	for (BaseObject *op = doc->GetFirstObject(); op && success; op = op->GetNext())
+	{
+		if (!GeneratesPolygons(op))
+			continue;
+
+		// Get polygon geometry. Polygon objects are used directly, everything else is converted.
+		const Bool isPolygonObject = op->GetType() == Opolygon;
+		PolygonObject *geometry = isPolygonObject ? ToPoly(op) : GetRealGeometry(op);
+		if (!geometry)
+			continue;
+
+		if (geometry->GetType() == Opolygon && geometry->GetPolygonCount() > 0)
+		{
+			// Tiles are stored in global space. The document is freed afterwards anyway, so the points can be transformed in place.
+			const Matrix mg = op->GetMg();
+			const Int32 pointCount = geometry->GetPointCount();
+			Vector *padr = geometry->GetPointW();
+			for (Int32 i = 0; i < pointCount; ++i)
+				padr[i] = mg * padr[i];
+
+			success = AddGeometry(geometry, thread);
+		}
+
+		if (!isPolygonObject)
+			PolygonObject::Free(geometry);
+	}
+
+	BaseDocument::Free(doc);
+	return success;
+}
+
+Bool wsTiledCollisionMeshWriter::Close()
+{
+	if (!_file)
+		return false;
+
+	// Index
+	const Int64 indexOffset = _file->GetPosition();
+	_file->WriteInt32((Int32)_tiles.GetCount());
+	for (const wsCollisionTile &tile : _tiles)
+	{
+		_file->WriteVector64(tile._min);
+		_file->WriteVector64(tile._max);
+		_file->WriteInt64(tile._offset);
+		_file->WriteInt64(tile._memorySize);
+		_file->WriteInt32(tile._triangleCount);
+	}
+
+	// Now the header can point to the index
+	_file->Seek(TILES_INDEX_POSITION, FILESEEK::START);
+	_file->WriteInt64(indexOffset);
+
+	// The helper arrays can be large, they're not needed anymore
+	_cornerNormals.Reset();
+	_centroids.Reset();
+	_polygons.Reset();
+
+	// BaseFile remembers write errors, Close() reports them
+	return _file->Close();
+}
+
+
+Bool wsTiledCollisionMesh::Open(const Filename &filename, Int memoryBudget)
+{
+	Close();
+	if (!_file || !_file->Open(filename, FILEOPEN::READ, FILEDIALOG::NONE, BYTEORDER::V_INTEL))
+		return false;
+
+	// Header
+	Int32 magic = 0;
+	Int32 version = 0;
+	Int64 indexOffset = 0;
+	if (!_file->ReadInt32(&magic) || !_file->ReadInt32(&version) || !_file->ReadInt64(&indexOffset) || magic != TILES_MAGIC || version != TILES_VERSION || indexOffset <= TILES_INDEX_POSITION)
+	{
+		Close();
+		return false;
+	}
+
+	// Index
+	Int32 tileCount = 0;
+	if (!_file->Seek(indexOffset, FILESEEK::START) || !_file->ReadInt32(&tileCount) || tileCount <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	// A damaged file must not make us allocate more memory than there is data
+	if ((Int64)tileCount * TILES_ENTRY_SIZE > _file->GetLength() - _file->GetPosition())
+	{
+		Close();
+		return false;
+	}
+
+	iferr (_tiles.Resize(tileCount))
+	{
+		Close();
+		return false;
+	}
+
+	_min = Vector(maxon::LIMIT<Float>::MAX);
+	_max = Vector(maxon::LIMIT<Float>::MIN);
+	for (wsCollisionTile &tile : _tiles)
+	{
+		_file->ReadVector64(&tile._min);
+		_file->ReadVector64(&tile._max);
+		_file->ReadInt64(&tile._offset);
+		_file->ReadInt64(&tile._memorySize);
+		_file->ReadInt32(&tile._triangleCount);
+		_min = Vector(Min(_min.x, tile._min.x), Min(_min.y, tile._min.y), Min(_min.z, tile._min.z));
+		_max = Vector(Max(_max.x, tile._max.x), Max(_max.y, tile._max.y), Max(_max.z, tile._max.z));
+	}
+	if (_file->GetError() != FILEERROR::NONE)
+	{
+		Close();
+		return false;
+	}
+
+	_memoryBudget = memoryBudget;
+	return true;
+}
+
+void wsTiledCollisionMesh::Close()
+{
+	while (!_cache.IsEmpty())
+		EvictTile();
+
+	if (_file)
+		_file->Close();
+
+	_tiles.Reset();
+	_candidates.Reset();
+	_homeTiles.Reset();
+	_order.Reset();
+	_tileStart.Reset();
+	_memoryUsed = 0;
+	_peakMemory = 0;
+	_useCounter = 0;
+	_loadCount = 0;
+	_failed = false;
+}
+
+void wsTiledCollisionMesh::EvictTile()
+{
+	if (_cache.IsEmpty())
+		return;
+
+	// Find the least recently used tile. There are only a few tiles in memory, so a linear search is fine.
+	Int oldest = 0;
+	for (Int i = 1; i < _cache.GetCount(); ++i)
+	{
+		if (_cache[i]._lastUse < _cache[oldest]._lastUse)
+			oldest = i;
+	}
+
+	_memoryUsed -= (Int)_tiles[_cache[oldest]._tile]._memorySize;
+	DeleteObj(_cache[oldest]._mesh);
+	_cache.SwapErase(oldest) iferr_ignore("Erasing doesn't allocate");
+}
+
+wsCollisionMesh *wsTiledCollisionMesh::GetTile(Int32 index)
+{
+	++_useCounter;
+
+	// Tile is already loaded
+	for (CachedTile &cached : _cache)
+	{
+		if (cached._tile == index)
+		{
+			cached._lastUse = _useCounter;
+			return cached._mesh;
+		}
+	}
+
+	// Make room for the tile
+	const Int memorySize = (Int)_tiles[index]._memorySize;
+	while (!_cache.IsEmpty() && _memoryUsed + memorySize > _memoryBudget)
+		EvictTile();
+
+	// Load the tile
+	wsCollisionMesh *mesh = NewObjClear(wsCollisionMesh);
+	if (!mesh || !_file->Seek(_tiles[index]._offset, FILESEEK::START) || !mesh->Read(_file))
+	{
+		DeleteObj(mesh);
+		_failed = true;
+		return nullptr;
+	}
+
+	iferr (_cache.Append(CachedTile{ index, mesh, _useCounter }))
+	{
+		DeleteObj(mesh);
+		_failed = true;
+		return nullptr;
+	}
+
+	_memoryUsed += memorySize;
+	_peakMemory = Max(_peakMemory, _memoryUsed);
+	++_loadCount;
+	return mesh;
+}
+
+Bool wsTiledCollisionMesh::CollectLineCandidates(const Vector &origin, const Vector &direction, Float maxDistance, Bool forwardOnly)
+{
+	_candidates.Flush();
+
+	// Division by zero gives infinity, the box test skips those axes
+	const Vector inverseDirection(1.0 / direction.x, 1.0 / direction.y, 1.0 / direction.z);
+
+	for (Int32 i = 0; i < (Int32)_tiles.GetCount(); ++i)
+	{
+		Float tNear, tFar;
+		if (!IntersectBox(origin, direction, inverseDirection, _tiles[i]._min, _tiles[i]._max, tNear, tFar))
+			continue;
+		if (tNear > maxDistance || tFar < (forwardOnly ? 0.0 : -maxDistance))
+			continue;
+
+		// Distance from the origin to the closest part of the tile along the line
+		const Float distance = (tNear <= 0.0 && tFar >= 0.0) ? 0.0 : Min(Abs(tNear), Abs(tFar));
+		iferr (_candidates.Append(Candidate{ i, distance }))
+			return false;
+	}
+
+	// Sort by distance. A line only passes through a few tiles, so insertion sort is fine.
+	for (Int i = 1; i < _candidates.GetCount(); ++i)
+	{
+		const Candidate candidate = _candidates[i];
+		Int j = i - 1;
+		for (; j >= 0 && _candidates[j]._distance > candidate._distance; --j)
+			_candidates[j + 1] = _candidates[j];
+		_candidates[j + 1] = candidate;
+	}
+
+	return true;
+}
+
+Bool wsTiledCollisionMesh::CollectPointCandidates(const Vector &position, Float maxDistance)
+{
+	_candidates.Flush();
+
+	const Float maxDistanceSquared = maxDistance > 0.0 ? maxDistance * maxDistance : maxon::LIMIT<Float>::MAX;
+	for (Int32 i = 0; i < (Int32)_tiles.GetCount(); ++i)
+	{
+		const Float distanceSquared = DistanceSquaredToBox(position, _tiles[i]._min, _tiles[i]._max);
+		if (distanceSquared > maxDistanceSquared)
+			continue;
+
+		iferr (_candidates.Append(Candidate{ i, distanceSquared }))
+			return false;
+	}
+
+	// Sort by distance
+	for (Int i = 1; i < _candidates.GetCount(); ++i)
+	{
+		const Candidate candidate = _candidates[i];
+		Int j = i - 1;
+		for (; j >= 0 && _candidates[j]._distance > candidate._distance; --j)
+			_candidates[j + 1] = _candidates[j];
+		_candidates[j + 1] = candidate;
+	}
+
+	return true;
+}
+
+Bool wsTiledCollisionMesh::IntersectRay(const Vector &origin, const Vector &rayDirection, Float rayLength, PROJECTORDIRECTION direction, Vector &hitPosition, Vector *hitNormal)
+{
+	const Float directionLength = rayDirection.GetLength();
+	if (directionLength == 0.0 || rayLength <= 0.0)
+		return false;
+
+	const Vector normalizedDirection = rayDirection / directionLength;
+	const Bool forwardOnly = direction == PROJECTORDIRECTION::FORWARD;
+	const Bool preferForward = direction != PROJECTORDIRECTION::BOTH_NEAREST;
+	if (!CollectLineCandidates(origin, normalizedDirection, rayLength, forwardOnly))
+		return false;
+
+	Bool found = false;
+	Float bestDistance = 0.0;
+	for (const Candidate &candidate : _candidates)
+	{
+		// Tiles further away than the best hit can't contain a better one.
+		// When forward hits are preferred, a backward hit can still be beaten by a forward hit in any tile.
+		if (found && candidate._distance >= Abs(bestDistance) && (!preferForward || bestDistance >= 0.0))
+			break;
+
+		wsCollisionMesh *mesh = GetTile(candidate._tile);
+		if (!mesh)
+			return false;
+
+		wsCollisionMeshHit hit;
+		if (!mesh->IntersectLine(origin, normalizedDirection, rayLength, preferForward, hit))
+			continue;
+		if (forwardOnly && hit._distance < 0.0)
+			continue;
+
+		// Compare with the best hit of the other tiles
+		Bool better = !found;
+		if (found)
+		{
+			if (preferForward && (hit._distance >= 0.0) != (bestDistance >= 0.0))
+				better = hit._distance >= 0.0;
+			else
+				better = Abs(hit._distance) < Abs(bestDistance);
+		}
+		if (!better)
+			continue;
+
+		// The normal is taken right away, the tile might be freed by the next GetTile() call
+		found = true;
+		bestDistance = hit._distance;
+		hitPosition = hit._position;
+		if (hitNormal)
+			*hitNormal = mesh->GetInterpolatedNormal(hit);
+	}
+
+	return found;
+}
+
+Bool wsTiledCollisionMesh::FindClosest(const Vector &position, Float maxDistance, Vector &hitPosition, Vector *hitNormal)
+{
+	if (!CollectPointCandidates(position, maxDistance))
+		return false;
+
+	Bool found = false;
+	Float bestDistance = maxDistance;
+	for (const Candidate &candidate : _candidates)
+	{
+		// Tiles further away than the best hit can't contain a better one
+		if (found && candidate._distance >= bestDistance * bestDistance)
+			break;
+
+		wsCollisionMesh *mesh = GetTile(candidate._tile);
+		if (!mesh)
+			return false;
+
+		wsCollisionMeshHit hit;
+		if (!mesh->GetClosestPoint(position, bestDistance, hit))
+			continue;
+		if (found && hit._distance >= bestDistance)
+			continue;
+
+		found = true;
+		bestDistance = hit._distance;
+		hitPosition = hit._position;
+		if (hitNormal)
+			*hitNormal = mesh->GetInterpolatedNormal(hit);
+	}
+
+	return found;
+}
+
+void wsTiledCollisionMesh::GetRay(const Vector &position, const wsPointProjectorParams &params, Vector &rayDirection, Float &rayLength) const
+{
+	// Parallel mode shoots along the modifier's Z axis, spherical mode away from the modifier
+	if (params._mode == PROJECTORMODE::SPHERICAL)
+		rayDirection = position - params._modifierMg.off;
+	else
+		rayDirection = params._modifierMg.sqmat.v3;
+
+	// Long enough to reach every tile
+	rayLength = (position - (_min + _max) * 0.5).GetLength() + (_max - _min).GetLength() * 0.5;
+}
+
+Bool wsTiledCollisionMesh::Project(Vector *points, Int32 pointCount, const wsPointProjectorParams &params, BaseThread *thread)
+{
+	if (!IsOpen() || !points || params._mode == PROJECTORMODE::NONE)
+		return false;
+	if (pointCount == 0)
+		return true;
+
+	const Bool closestPoint = params._mode == PROJECTORMODE::CLOSESTPOINT;
+	const Int32 tileCount = GetTileCount();
+	Vector rayDirection(DC);
+	Float rayLength = 0.0;
+
+	// Find the tile each point is most likely to hit. Points that can't hit any tile go to an extra bucket at the end.
+	iferr (_homeTiles.Resize(pointCount))
+		return false;
+	iferr (_order.Resize(pointCount))
+		return false;
+	iferr (_tileStart.Resize(tileCount + 2))
+		return false;
+	for (Int32 i = 0; i < tileCount + 2; ++i)
+		_tileStart[i] = 0;
+
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		Bool success = true;
+		if (closestPoint)
+		{
+			success = CollectPointCandidates(points[i], params._maxSearchDist);
+		}
+		else
+		{
+			// A point without ray direction doesn't hit anything
+			GetRay(points[i], params, rayDirection, rayLength);
+			const Float directionLength = rayDirection.GetLength();
+			if (directionLength == 0.0)
+				_candidates.Flush();
+			else
+				success = CollectLineCandidates(points[i], rayDirection / directionLength, rayLength, params._direction == PROJECTORDIRECTION::FORWARD);
+		}
+		if (!success)
+			return false;
+
+		_homeTiles[i] = _candidates.IsEmpty() ? tileCount : _candidates[0]._tile;
+		++_tileStart[_homeTiles[i] + 1];
+	}
+
+	// Sort points by tile (counting sort), so each tile is loaded about once
+	for (Int32 i = 1; i < tileCount + 2; ++i)
+		_tileStart[i] += _tileStart[i - 1];
+	for (Int32 i = 0; i < pointCount; ++i)
+		_order[_tileStart[_homeTiles[i]]++] = i;
+
+	// Project points in tile order
+	const Float geometryFalloffDistSquared = params._geometryFalloffDist * params._geometryFalloffDist;
+	Vector hitPosition(DC);
+	Vector hitNormal(DC);
+	for (Int32 s = 0; s < pointCount; ++s)
+	{
+		// Check if procesing should be cancelled. Only part of the points would be projected.
+		if (thread && !(s & 63) && thread->TestBreak())
+			return false;
+
+		const Int32 i = _order[s];
+
+		// Nothing to hit
+		if (_homeTiles[i] == tileCount)
+			continue;
+
+		const Vector originalPosition = points[i];
+		Vector position = originalPosition;
+
+		// Find the hit position
+		Bool hit;
+		if (closestPoint)
+		{
+			hit = FindClosest(originalPosition, params._maxSearchDist, hitPosition, params._offset != 0.0 ? &hitNormal : nullptr);
+		}
+		else
+		{
+			GetRay(originalPosition, params, rayDirection, rayLength);
+			hit = IntersectRay(originalPosition, rayDirection, rayLength, params._direction, hitPosition, params._offset != 0.0 ? &hitNormal : nullptr);
+		}
+		if (_failed)
+			return false;
+
+		if (hit)
+		{
+			position = hitPosition;
+
+			// Apply offset
+			if (params._offset != 0.0)
+				position += hitNormal * params._offset;
+
+			// Apply blend
+			if (params._blend != 1.0)
+				position = Blend(originalPosition, position, params._blend);
+		}
+
+		// Calculate geometry falloff
+		if (params._geometryFalloffEnabled)
+		{
+			const Float distanceSquared = (position - originalPosition).GetSquaredLength();
+			if (distanceSquared < geometryFalloffDistSquared)
+				position = Blend(position, originalPosition, Smoothstep(0.0, geometryFalloffDistSquared, distanceSquared));
+			else
+				position = originalPosition;
+		}
+
+		// Evaluate falloff at the original position
+		if (params.HasFalloff())
+		{
+			Float falloffResult = 1.0;
+			if (params._falloffValues)
+				falloffResult = params._falloffValues[i];
+			else
+				params._falloff->Sample(originalPosition, &falloffResult);
+			if (falloffResult < 1.0)
+				position = Blend(originalPosition, position, falloffResult);
+		}
+
+		// Evaluate weight map
+		if (params._weightMap)
+		{
+			const Float32 weight = params._weightMap[i];
+			if (weight < 1.0)
+				position = Blend(originalPosition, position, (Float)weight);
+		}
+
+		points[i] = position;
+	}
+
+	return true;
+}
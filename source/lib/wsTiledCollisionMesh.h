@@ -0,0 +1,198 @@
+#ifndef WS_TILEDCOLLISIONMESH_H__
+#define WS_TILEDCOLLISIONMESH_H__
+
+
+#include "c4d.h"
+#include "wsCollisionMesh.h"
+#include "wsPointProjector.h"
+
+
+/// Entry of the top-level index of a tiled collision mesh
+struct wsCollisionTile
+{
+	Vector _min;                ///< Minimum of the tile's bounding box (global space)
+	Vector _max;                ///< Maximum of the tile's bounding box (global space)
+	Int64  _offset = 0;         ///< Position of the tile's data in the file
+	Int64  _memorySize = 0;     ///< Number of bytes the tile needs when it's loaded
+	Int32  _triangleCount = 0;  ///< Number of triangles in the tile
+};
+
+
+/// Writes a tiled collision mesh file.
+/// Each tile is a wsCollisionMesh with its hierarchy already built. Geometry is split spatially into tiles with a limited number of polygons, and tiles are written one by one, so only one of them has to be in memory at a time.
+class wsTiledCollisionMeshWriter
+{
+private:
+	AutoAlloc<BaseFile>                _file;           ///< The file that's being written
+	maxon::BaseArray<wsCollisionTile>  _tiles;          ///< Index of the tiles written so far
+	maxon::BaseArray<Vector32>         _cornerNormals;  ///< Vertex normals of the geometry that's being split
+	maxon::BaseArray<Vector>           _centroids;      ///< Centroid of each polygon of the geometry that's being split
+	maxon::BaseArray<Int32>            _polygons;       ///< Polygon indices of the geometry that's being split, grouped by tile
+	Int32                              _maxPolygons;    ///< Maximum number of polygons per tile
+
+	/// Build a tile from a part of the geometry, and write it to the file
+	Bool WriteTile(const PolygonObject *polyObject, const Int32 *polygons, Int32 polygonCount, BaseThread *thread);
+
+public:
+	/// Create the file
+	/// @param filename The file to write
+	/// @param maxPolygons Maximum number of polygons per tile. Bounds the memory a single tile needs when it's loaded.
+	/// @return False if the file could not be created, otherwise true
+	Bool Open(const Filename &filename, Int32 maxPolygons);
+
+	/// Split polygon geometry into tiles, and write them to the file
+	/// @param polyObject The geometry. Its points must be in global space. Caller owns the pointed object.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if a tile could not be built or written, otherwise true
+	Bool AddGeometry(const PolygonObject *polyObject, BaseThread *thread = nullptr);
+
+	/// Load a scene file, and add the geometry of each top-level object that generates polygons. The scene is freed before returning.
+	/// @param sceneFile The scene file to load
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if the scene could not be loaded or a tile could not be written, otherwise true
+	Bool AddScene(const Filename &sceneFile, BaseThread *thread = nullptr);
+
+	/// Write the index, and close the file
+	/// @return False if writing failed, otherwise true
+	Bool Close();
+
+	/// @return Number of tiles written so far
+	Int32 GetTileCount() const
+	{
+		return (Int32)_tiles.GetCount();
+	}
+
+	/// Default constructor
+	wsTiledCollisionMeshWriter() : _maxPolygons(0)
+	{ }
+};
+
+
+/// Collision geometry that's too large for memory, split into tiles that are stored on disk.
+/// Only the index with the tiles' bounding boxes is kept in memory. Tiles are loaded when a query needs them, and the least recently used tiles are freed when the memory budget is exceeded.
+/// @note All positions are in global space.
+class wsTiledCollisionMesh
+{
+private:
+	/// A tile that's currently loaded
+	struct CachedTile
+	{
+		Int32             _tile;     ///< Index of the tile
+		wsCollisionMesh  *_mesh;     ///< The loaded tile. Owned by the cache.
+		UInt64            _lastUse;  ///< Value of _useCounter when the tile was last used
+	};
+
+	/// A tile that might contain the result of a query
+	struct Candidate
+	{
+		Int32 _tile;      ///< Index of the tile
+		Float _distance;  ///< Distance between query and tile's bounding box. Squared for closest point queries.
+	};
+
+	AutoAlloc<BaseFile>                _file;          ///< The tile file, kept open for loading tiles
+	maxon::BaseArray<wsCollisionTile>  _tiles;         ///< Top-level index
+	maxon::BaseArray<CachedTile>       _cache;         ///< Tiles that are currently loaded
+	maxon::BaseArray<Candidate>        _candidates;    ///< Candidates of the current query, sorted by distance
+	maxon::BaseArray<Int32>            _homeTiles;     ///< First candidate tile of each point, used to sort points by tile
+	maxon::BaseArray<Int32>            _order;         ///< Order in which points are projected
+	maxon::BaseArray<Int32>            _tileStart;     ///< First position in _order of each tile's points
+	Vector                             _min;           ///< Minimum of the bounding box of all tiles
+	Vector                             _max;           ///< Maximum of the bounding box of all tiles
+	Int                                _memoryBudget;  ///< Number of bytes loaded tiles may use
+	Int                                _memoryUsed;    ///< Number of bytes used by loaded tiles
+	Int                                _peakMemory;    ///< Largest value of _memoryUsed so far
+	UInt64                             _useCounter;    ///< Increased with each tile access
+	Int32                              _loadCount;     ///< Number of times a tile has been loaded from disk
+	Bool                               _failed;        ///< Indicates if a tile could not be loaded
+
+	/// Get a tile, load it from disk if necessary. Least recently used tiles are freed to stay within the memory budget.
+	/// @return The tile, or nullptr if it could not be loaded. Only valid until the next call.
+	wsCollisionMesh *GetTile(Int32 index);
+
+	/// Free the least recently used tile
+	void EvictTile();
+
+	/// Fill _candidates with the tiles an infinite line passes through, sorted by distance from the origin
+	/// @param direction Normalized direction of the line
+	/// @param forwardOnly If true, only tiles in front of the origin are collected
+	Bool CollectLineCandidates(const Vector &origin, const Vector &direction, Float maxDistance, Bool forwardOnly);
+
+	/// Fill _candidates with the tiles within reach of a position, sorted by distance
+	/// @param maxDistance Search radius, 0.0 means unlimited
+	Bool CollectPointCandidates(const Vector &position, Float maxDistance);
+
+	/// Get ray direction and length for a point, depending on the projection mode
+	void GetRay(const Vector &position, const wsPointProjectorParams &params, Vector &rayDirection, Float &rayLength) const;
+
+public:
+	/// Open a tile file, and read the index
+	/// @param filename The file written by wsTiledCollisionMeshWriter
+	/// @param memoryBudget Number of bytes loaded tiles may use. A tile that's larger than the budget is still loaded, but it's the only one. The tile size is limited when the file is written.
+	/// @return False if the file could not be read, otherwise true
+	Bool Open(const Filename &filename, Int memoryBudget);
+
+	/// Free all tiles, and close the file
+	void Close();
+
+	/// @return True if a tile file is open
+	Bool IsOpen() const
+	{
+		return !_tiles.IsEmpty();
+	}
+
+	/// @return Number of tiles in the index
+	Int32 GetTileCount() const
+	{
+		return (Int32)_tiles.GetCount();
+	}
+
+	/// @return Number of times a tile has been loaded from disk
+	Int32 GetLoadCount() const
+	{
+		return _loadCount;
+	}
+
+	/// @return Largest number of bytes that loaded tiles have used at the same time
+	Int GetPeakMemory() const
+	{
+		return _peakMemory;
+	}
+
+	/// Find the nearest intersection of a ray with the tiles
+	/// @param origin Origin of the ray
+	/// @param rayDirection Direction of the ray, does not need to be normalized
+	/// @param rayLength Only intersections within this distance are found
+	/// @param direction Shoot only forward, or in both directions along the ray
+	/// @param hitPosition Receives the hit position
+	/// @param hitNormal If set, receives the interpolated surface normal at the hit position
+	/// @return True if something was hit, otherwise false
+	Bool IntersectRay(const Vector &origin, const Vector &rayDirection, Float rayLength, PROJECTORDIRECTION direction, Vector &hitPosition, Vector *hitNormal);
+
+	/// Find the closest position on the tiles
+	/// @param position Query position
+	/// @param maxDistance Search radius, pass 0.0 for an unlimited search
+	/// @param hitPosition Receives the closest position
+	/// @param hitNormal If set, receives the interpolated surface normal at the closest position
+	/// @return True if something was found within the search radius, otherwise false
+	Bool FindClosest(const Vector &position, Float maxDistance, Vector &hitPosition, Vector *hitNormal);
+
+	/// Project points on the tiles. Points are sorted by the tile they're most likely to hit, so each tile is loaded about once per call.
+	/// @param points The points (global space). They also receive the results.
+	/// @param pointCount Number of points
+	/// @param params Parameters for projection. Falloffs must be passed as sampled values in params._falloffValues, or as a falloff that's valid in global space.
+	/// @param thread If called in a threaded context, pass the pointer to the thread here
+	/// @return False if there was a problem, a tile could not be loaded, or processing was cancelled, otherwise true
+	Bool Project(Vector *points, Int32 pointCount, const wsPointProjectorParams &params, BaseThread *thread = nullptr);
+
+	/// Default constructor
+	wsTiledCollisionMesh() : _memoryBudget(0), _memoryUsed(0), _peakMemory(0), _useCounter(0), _loadCount(0), _failed(false)
+	{ }
+
+	/// Destructor
+	~wsTiledCollisionMesh()
+	{
+		Close();
+	}
+};
+
+#endif // WS_TILEDCOLLISIONMESH_H__
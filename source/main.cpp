@@ -1,15 +1,22 @@
 #include "maxon/apibase.h"
 #include "c4d_symbols.h"
 #include "wsPointProjector.h"
+#include "wsEvaluationCapture.h"
+#include "wsTiledCollisionMesh.h"
 #include "main.h"
 
 
-#define PLUGIN_NAME "PointProjector 1.4.4"
+#define PLUGIN_NAME "PointProjector 1.5"
+
+
+static const Int32 DEFAULT_REPLAY_REPEAT = 10;        ///< Number of runs when replaying a capture
+static const Int32 DEFAULT_TILE_MEMORY = 512;        ///< Memory budget for loaded tiles in MB
+static const Int32 DEFAULT_TILE_POLYGONS = 262144;  ///< Maximum number of polygons per tile when building tiles
 
 
 Bool PluginStart()
 {
-	String pluginName = "PointProjector 1.4.4"_s;
+	String pluginName = "PointProjector 1.5"_s;
 	GePrint(pluginName);
 	
 	if (!RegisterProjectorObject())
@@ -23,12 +30,134 @@ void PluginEnd()
 { }
 
 
+/// Build a tile file from scene files. The geometry of each top-level object that generates polygons is split into tiles of at most maxPolygons polygons.
+static void BuildTiles(const Filename &tileFile, const maxon::BaseArray<Filename> &sceneFiles, Int32 maxPolygons)
+{
+	wsTiledCollisionMeshWriter writer;
+	if (!writer.Open(tileFile, maxPolygons))
+	{
+		GePrint("PointProjector: Could not create tile file "_s + tileFile.GetString());
+		return;
+	}
+
+	// Scenes are loaded one at a time, so only one of them has to fit into memory
+	for (const Filename &sceneFile : sceneFiles)
+	{
+		if (!writer.AddScene(sceneFile))
+			GePrint("PointProjector: Could not add tiles from "_s + sceneFile.GetString());
+	}
+
+	if (writer.Close())
+		GePrint("PointProjector: Wrote "_s + String::IntToString(writer.GetTileCount()) + " tiles to "_s + tileFile.GetString());
+	else
+		GePrint("PointProjector: Could not write tile file "_s + tileFile.GetString());
+}
+
+/// Handle the command line options of the batch tools.
+/// Usage:
+///   -pointprojector_replay <file> [-pointprojector_repeat <count>] [-pointprojector_generic] [-pointprojector_tiles <tile file> [-pointprojector_tilememory <MB>]]
+///   -pointprojector_buildtiles <tile file> <scene file> [<scene file> ...] [-pointprojector_tilepolygons <count>]
+static void HandleCommandLineArgs(C4DPL_CommandLineArgs *args)
+{
+	if (!args || !args->argv)
+		return;
+
+	Filename replayFile;
+	Filename tileFile;
+	Filename buildTileFile;
+	maxon::BaseArray<Filename> sceneFiles;
+	Int32 repeat = DEFAULT_REPLAY_REPEAT;
+	Int32 tileMemory = DEFAULT_TILE_MEMORY;
+	Int32 tilePolygons = DEFAULT_TILE_POLYGONS;
+	Bool generic = false;
+	for (Int32 i = 0; i < args->argc; ++i)
+	{
+		if (!args->argv[i])
+			continue;
+
+		// Options without value
+		if (strcmp(args->argv[i], "-pointprojector_generic") == 0)
+		{
+			generic = true;
+			args->argv[i] = nullptr;
+			continue;
+		}
+
+		if (i + 1 >= args->argc || !args->argv[i + 1])
+			continue;
+
+		Bool takeSceneFiles = false;
+		if (strcmp(args->argv[i], "-pointprojector_replay") == 0)
+			replayFile = Filename(String(args->argv[i + 1]));
+		else if (strcmp(args->argv[i], "-pointprojector_repeat") == 0)
+			repeat = String(args->argv[i + 1]).ToInt32(nullptr);
+		else if (strcmp(args->argv[i], "-pointprojector_tiles") == 0)
+			tileFile = Filename(String(args->argv[i + 1]));
+		else if (strcmp(args->argv[i], "-pointprojector_tilememory") == 0)
+			tileMemory = String(args->argv[i + 1]).ToInt32(nullptr);
+		else if (strcmp(args->argv[i], "-pointprojector_tilepolygons") == 0)
+			tilePolygons = String(args->argv[i + 1]).ToInt32(nullptr);
+		else if (strcmp(args->argv[i], "-pointprojector_buildtiles") == 0)
+		{
+			buildTileFile = Filename(String(args->argv[i + 1]));
+			takeSceneFiles = true;
+		}
+		else
+		{
+			continue;
+		}
+
+		// Mark the arguments as consumed
+		args->argv[i] = nullptr;
+		args->argv[i + 1] = nullptr;
+		++i;
+
+		// Building tiles takes all following arguments that are not options
+		if (takeSceneFiles)
+		{
+			while (i + 1 < args->argc && args->argv[i + 1] && args->argv[i + 1][0] != '-')
+			{
+				iferr (sceneFiles.Append(Filename(String(args->argv[i + 1]))))
+					return;
+				args->argv[++i] = nullptr;
+			}
+		}
+	}
+
+	if (buildTileFile.IsPopulated())
+		BuildTiles(buildTileFile, sceneFiles, tilePolygons);
+
+	if (!replayFile.IsPopulated())
+		return;
+
+	if (tileFile.IsPopulated())
+	{
+		// Project on tiles, with bounded memory
+		wsTiledCollisionMesh tiles;
+		if (!tiles.Open(tileFile, (Int)Max(tileMemory, (Int32)1) << 20))
+		{
+			GePrint("PointProjector: Could not open tile file "_s + tileFile.GetString());
+			return;
+		}
+		ReplayEvaluationCapture(replayFile, repeat, &tiles);
+	}
+	else
+	{
+		ReplayEvaluationCapture(replayFile, repeat, nullptr, generic);
+	}
+}
+
+
 Bool PluginMessage(Int32 id, void *data)
 {
 	switch (id)
 	{
 		case C4DPL_INIT_SYS:
 			return g_resource.Init();  // don't start plugin without resource
+
+		case C4DPL_COMMANDLINEARGS:
+			HandleCommandLineArgs(static_cast<C4DPL_CommandLineArgs*>(data));
+			return true;
 	}
 
 	return false;
@@ -3,11 +3,17 @@
 #include "c4d_symbols.h"
 #include "oProjector.h"
 #include "wsPointProjector.h"
+#include "wsProgressiveProjection.h"
+#include "wsCollisionBuilder.h"
+#include "wsEvaluationCapture.h"
+#include "wsSplineResampler.h"
+#include "wsPointCache.h"
 #include "wsFunctions.h"
 #include "main.h"
 
 
 static const Int32 ID_PROJECTOROBJECT = 1026403; ///< PointProjector plugin ID
+static const Float64 PROGRESSIVE_TIME_SLICE = 100.0; ///< Time in milliseconds that progressive projection may spend on refinement per evaluation
 
 
 /// Object plugin class
@@ -17,12 +23,65 @@ class oProjector : public ObjectData
 	INSTANCEOF(oProjector, ObjectData)
 	
 private:
-	wsPointProjector        _projector;      ///< Projector object that does all the work for us (and nicely separates the projection code from the Deformer/Object code)
-	UInt32                  _lastDirtyness;  ///< Used to store the last retreived dirty checksum for later comparison
-	AutoAlloc<C4D_Falloff>  _falloff;        ///< Provides the functions needed to support falloffs
+	wsCollisionCache         *_collision;          ///< Collision geometry, and the projector object that does all the work for us (and nicely separates the projection code from the Deformer/Object code)
+	wsCollisionBuilder        _builder;            ///< Builds the collision cache in the background, so the editor doesn't block
+	UInt64                    _requestedChecksum;  ///< Checksum of the collision input the last background build was requested for
+	UInt32                    _lastDirtyness;      ///< Used to store the last retreived dirty checksum for later comparison
+	AutoAlloc<C4D_Falloff>    _falloff;            ///< Provides the functions needed to support falloffs
+	wsPointSubsampler         _subsampler;         ///< Selects the points that are projected in the editor, if editor quality is below 100%
+	UInt64                    _subsamplerKey;      ///< Key of the input _subsampler has been initialized for, or 0
+	wsProgressiveProjection   _progressive;        ///< Refines the projection over several evaluations, if progressive projection is enabled
+	wsSplineResampler         _resampler;          ///< Adds points to splines where the projection needs them, if adaptive spline is enabled
+	maxon::BaseArray<Float32> _weights;            ///< Weight map calculated from the restriction tag, kept until the vertex maps change
+	UInt64                    _weightsChecksum;    ///< Checksum of restriction tag and vertex maps the weight map was calculated from
+	Bool                      _hasWeights;         ///< Indicates if _weights contains a weight map
+	Bool                      _captureRequested;   ///< Indicates if the next evaluation should be written to the capture file
+	wsPointCache              _pointCache;         ///< Baked frames, streamed from the point cache file during playback and rendering
+	wsPointCacheWriter       *_bakeWriter;         ///< Receives the result of each evaluation while baking. Only set on the projector in the document clone that's used for baking.
+	maxon::AtomicInt32        _bakeEvaluations;    ///< Number of objects deformed in the frame that's being baked
+	BaseTime                  _evaluatedTime;      ///< Document time of the last evaluation, used to find out if the time changed
+	maxon::BaseArray<Float>   _falloffValues;      ///< Falloff sampled at each point while the point cache is used or baked. Passed on to the projection, so it's not sampled twice.
+	UInt64                    _collisionHashKey;   ///< Dirty state of the linked object when _collisionHash was computed
+	UInt64                    _collisionHash;      ///< Hash of the linked object's geometry, used for the point cache fingerprint
+
+	/// Returns the weight map from the vertex maps linked in the restriction tag. It is only recalculated if the restriction tag or the vertex maps changed.
+	/// @return The weight map, or nullptr if there is none. Owned by oProjector, valid until the next call.
+	Float32 *GetWeightMap(BaseObject *mod, PointObject *op);
+
+	/// Combines the linked object and the dirty checksums of it and its children. Changes whenever its geometry might have changed.
+	UInt64 GetCollisionDirtyness(BaseObject *collisionObject) const;
+
+	/// Computes a checksum of everything the collision cache depends on: The linked object, its geometry, and the acceleration structures needed by the parameters
+	UInt64 GetCollisionChecksum(BaseObject *collisionObject, const BaseContainer &bc) const;
+
+	/// Computes a key of everything the editor subsampler depends on: Point count, segments, editor quality, and the dirty state of the deformed object's points
+	UInt64 GetSubsamplerKey(BaseObject *mod, PointObject *op, Float editorQuality) const;
+
+	/// Adds up the dirty checksums of the falloff and its fields
+	UInt32 GetFalloffDirtyness(BaseObject *op, BaseDocument *doc);
+
+	/// Computes a fingerprint of everything that influences the projection, used to find out if progressive projection has to start over
+	UInt64 GetInputFingerprint(BaseObject *mod, BaseDocument *doc, PointObject *op, BaseObject *collisionObject, const Float32 *weightMap);
+
+	/// Projects all points, and writes input, parameters and result to the capture file
+	Bool CaptureEvaluation(const Filename &filename, PointObject *op, wsPointProjector &projector, const wsPointProjectorParams &params, const Matrix &collisionObjectMg, BaseThread *thread);
+
+	/// Samples the falloff at the points of op, and stores the values in _falloffValues
+	Bool SampleFalloff(PointObject *op);
+
+	/// Computes a fingerprint of the input of a baked frame: The points, the matrices, the collision geometry, the weight map, the falloff values and the parameters.
+	/// Unlike GetInputFingerprint(), it doesn't use dirty checksums, so it's the same in every clone of the document.
+	/// @param falloffValues The falloff sampled at each point, see SampleFalloff()
+	UInt64 GetBakeFingerprint(BaseObject *mod, PointObject *op, BaseObject *collisionObject, const BaseContainer &bc, const Float32 *weightMap, const Float *falloffValues);
+
+	/// Evaluates a clone of the document for each frame of the bake range, and writes the results to the point cache file. Pressing Escape cancels baking.
+	/// @param mod The modifier. Caller owns the pointed object.
+	/// @return False if there was a problem, otherwise true
+	Bool Bake(BaseObject *mod);
 	
 public:
 	virtual Bool Init(GeListNode *node);
+	virtual void Free(GeListNode *node);
 	virtual Bool Message(GeListNode *node, Int32 type, void *data);
 	virtual DRAWRESULT Draw(BaseObject *op, DRAWPASS drawpass, BaseDraw *bd, BaseDrawHelp *bh);
 	virtual Bool ModifyObject(BaseObject *mod, BaseDocument *doc, BaseObject *op, const Matrix &op_mg, const Matrix &mod_mg, Float lod, Int32 flags, BaseThread *thread);
@@ -33,7 +92,7 @@ public:
 
 	static NodeData *Alloc();
 	
-	oProjector() : _lastDirtyness(0)
+	oProjector() : _collision(nullptr), _requestedChecksum(0), _lastDirtyness(0), _subsamplerKey(0), _weightsChecksum(0), _hasWeights(false), _captureRequested(false), _bakeWriter(nullptr), _collisionHashKey(0), _collisionHash(0)
 	{ }
 };
 
@@ -51,14 +110,38 @@ Bool oProjector::Init(GeListNode *node)
 	
 	// Init projection mode attributes
 	bc->SetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL);
+	bc->SetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD);
 	bc->SetFloat(PROJECTOR_OFFSET, 0.0);
 	bc->SetFloat(PROJECTOR_BLEND, 1.0);
 	bc->SetBool(PROJECTOR_GEOMFALLOFF_ENABLE, false);
 	bc->SetFloat(PROJECTOR_GEOMFALLOFF_DIST, 150.0);
+	bc->SetBool(PROJECTOR_MAXDIST_ENABLE, false);
+	bc->SetFloat(PROJECTOR_MAXDIST, 100.0);
+	bc->SetBool(PROJECTOR_SDF_ENABLE, false);
+	bc->SetInt32(PROJECTOR_SDF_RESOLUTION, 128);
+	bc->SetFloat(PROJECTOR_EDITOR_QUALITY, 1.0);
+	bc->SetBool(PROJECTOR_PROGRESSIVE, false);
+	bc->SetBool(PROJECTOR_SPLINE_ADAPTIVE, false);
+	bc->SetFloat(PROJECTOR_SPLINE_TOLERANCE, 1.0);
+	bc->SetInt32(PROJECTOR_SPLINE_MAXDEPTH, 6);
+	bc->SetInt32(PROJECTOR_BAKE_FROM, 0);
+	bc->SetInt32(PROJECTOR_BAKE_TO, 90);
+	bc->SetFloat(PROJECTOR_BAKE_PRECISION, 0.01);
+	bc->SetBool(PROJECTOR_BAKE_USE, false);
 
 	return SUPER::Init(node);
 }
 
+// Free private data
+void oProjector::Free(GeListNode *node)
+{
+	// Stop the background build, and free the collision cache
+	_builder.Cancel();
+	DeleteObj(_collision);
+
+	SUPER::Free(node);
+}
+
 // Catch messages
 Bool oProjector::Message(GeListNode *node, Int32 type, void *data)
 {
@@ -102,6 +185,43 @@ Bool oProjector::Message(GeListNode *node, Int32 type, void *data)
 			}
 			break;
 		}
+
+		// The user clicked a button
+		case MSG_DESCRIPTION_COMMAND:
+		{
+			if (!data)
+				return false;
+
+			// Capture the next evaluation. It happens in ModifyObject(), as that's where all the input is available.
+			DescriptionCommand* msgData = (DescriptionCommand*)data;
+			if (msgData->_descId[0].id == PROJECTOR_CAPTURE)
+			{
+				_captureRequested = true;
+				(static_cast<BaseObject*>(node))->SetDirty(DIRTYFLAGS::DATA);
+				EventAdd();
+				return true;
+			}
+
+			// Bake the frame range, and play it back from the point cache
+			if (msgData->_descId[0].id == PROJECTOR_BAKE)
+			{
+				BaseObject *op = static_cast<BaseObject*>(node);
+				const Filename bakeFile = bc->GetFilename(PROJECTOR_BAKE_FILE);
+				if (Bake(op))
+				{
+					GePrint("PointProjector: Point cache baked to "_s + bakeFile.GetString());
+					bc->SetBool(PROJECTOR_BAKE_USE, true);
+				}
+				else
+				{
+					GePrint("PointProjector: Could not bake point cache to "_s + bakeFile.GetString());
+				}
+				op->SetDirty(DIRTYFLAGS::DATA);
+				EventAdd();
+				return true;
+			}
+			break;
+		}
 	}
 
 	// Forward messages to the falloff, it might need them
@@ -139,15 +259,19 @@ DRAWRESULT oProjector::Draw(BaseObject *op, DRAWPASS drawpass, BaseDraw *bd, Bas
 		// Get projector mode
 		PROJECTORMODE mode = (PROJECTORMODE)bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL);
 		
-		// Draw arrows in parallel mode, or star in spherical mode
+		// Draw arrows in parallel mode, or star in spherical mode. Closest point mode doesn't have a direction, so nothing is drawn.
 		if (mode == PROJECTORMODE::PARALLEL)
 		{
 			DrawArrow(bd, Vector(50.0, 0.0, 0.0), 100.0, true);
 			DrawArrow(bd, Vector(-50.0, 0.0, 0.0), 100.0, true);
 			DrawArrow(bd, Vector(0.0, 50.0, 0.0), 100.0, true);
 			DrawArrow(bd, Vector(0.0, -50.0, 0.0), 100.0, true);
+
+			// Rays are also shot backwards
+			if (bc->GetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD) != PROJECTOR_DIRECTION_FORWARD)
+				DrawArrow(bd, Vector(0.0), -100.0, false);
 		}
-		else
+		else if (mode == PROJECTORMODE::SPHERICAL)
 		{
 			DrawStar(bd, Vector(0.0), 100.0);
 		}
@@ -162,6 +286,311 @@ DRAWRESULT oProjector::Draw(BaseObject *op, DRAWPASS drawpass, BaseDraw *bd, Bas
 	return SUPER::Draw(op, drawpass, bd, bh);
 }
 
+// Get cached weight map
+Float32 *oProjector::GetWeightMap(BaseObject *mod, PointObject *op)
+{
+	// Without restriction tag, there's no weight map
+	BaseTag *restrictionTag = mod->GetTag(Trestriction);
+	if (!restrictionTag)
+	{
+		_weightsChecksum = 0;
+		_hasWeights = false;
+		return nullptr;
+	}
+
+	// Checksum of restriction tag and all vertex maps it could refer to.
+	// op is usually a fresh copy of the deformed object, so the dirty checksums of the vertex maps on the original object are used.
+	// Only if the deformed object is a generator's cache, the vertex maps exist nowhere else, and their contents are hashed.
+	const Int32 pointCount = op->GetPointCount();
+	UInt64 checksum = HashMemory(&pointCount, sizeof(pointCount));
+	const UInt32 restrictionDirtyness = restrictionTag->GetDirty(DIRTYFLAGS::DATA);
+	checksum = HashMemory(&restrictionDirtyness, sizeof(restrictionDirtyness), checksum);
+	BaseObject *source = mod->GetUp();
+	const Bool useDirtyness = source && source->IsInstanceOf(Opoint) && ToPoint(source)->GetPointCount() == pointCount;
+	for (BaseTag *tag = useDirtyness ? source->GetFirstTag() : op->GetFirstTag(); tag; tag = tag->GetNext())
+	{
+		if (!tag->IsInstanceOf(Tvertexmap))
+			continue;
+
+		// The restriction tag refers to vertex maps by name
+		const UInt nameHash = tag->GetName().GetHashCode();
+		checksum = HashMemory(&nameHash, sizeof(nameHash), checksum);
+		if (useDirtyness)
+		{
+			const UInt32 dirtyness = tag->GetDirty(DIRTYFLAGS::DATA);
+			checksum = HashMemory(&dirtyness, sizeof(dirtyness), checksum);
+		}
+		else
+		{
+			VariableTag *vertexMap = static_cast<VariableTag*>(tag);
+			checksum = HashMemory(vertexMap->GetLowlevelDataAddressR(), vertexMap->GetDataCount() * sizeof(Float32), checksum);
+		}
+	}
+
+	// Nothing changed, use the cached weight map
+	if (checksum == _weightsChecksum)
+		return _hasWeights ? _weights.GetFirst() : nullptr;
+
+	// Calculate weight map, and copy it into the cache. Once the cache has grown to the point count, no more memory is allocated for it.
+	_weightsChecksum = checksum;
+	_hasWeights = false;
+	Float32 *weightMap = op->CalcVertexMap(mod);
+	if (!weightMap)
+		return nullptr;
+
+	iferr (_weights.Resize(pointCount))
+	{
+		DeleteMem(weightMap);
+		_weightsChecksum = 0;
+		return nullptr;
+	}
+	CopyMem(weightMap, _weights.GetFirst(), pointCount * sizeof(Float32));
+	DeleteMem(weightMap);
+	_hasWeights = true;
+
+	return _weights.GetFirst();
+}
+
+// Add up dirty checksums of falloff and fields
+UInt32 oProjector::GetFalloffDirtyness(BaseObject *op, BaseDocument *doc)
+{
+	UInt32 dirtyness = 0;
+
+#if API_VERSION >= 23000
+	if (_falloff)
+	{
+		dirtyness += _falloff->GetDirty(doc);
+
+		// Check for dirty fields
+		GeData geFieldData;
+		if (op->GetParameter(FIELDS, geFieldData, DESCFLAGS_GET::NONE))
+		{
+			// Get FieldList
+			CustomDataType* const fieldData = geFieldData.GetCustomDataType(CUSTOMDATATYPE_FIELDLIST);
+			FieldList* const fieldList  = static_cast<FieldList*>(fieldData);
+			if (fieldList)
+			{
+				dirtyness += fieldList->GetDirty(doc);
+
+				if (fieldList->HasContent())
+				{
+					// Dirty field objects
+					GeListHead *listHead = fieldList->GetLayersRoot();
+					if (listHead)
+					{
+						for (FieldLayer *layer = static_cast<FieldLayer*>(listHead->GetFirst()); layer; layer = IterateNextFieldLayer(layer))
+						{
+							// Layer node (in list)
+							dirtyness += layer->GetDirty(DIRTYFLAGS::DATA);
+
+							// Actual field object
+							const FieldLayerLink layerLink = layer->GetLinkedObject(doc);
+							BaseObject *fieldObject = static_cast<BaseObject*>(layerLink._object);
+							if (fieldObject)
+							{
+								dirtyness += fieldObject->GetDirty(DIRTYFLAGS::CACHE|DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX);
+							}
+						}
+					}
+				}
+			}
+		}
+
+	}
+#endif
+
+	return dirtyness;
+}
+
+// Compute fingerprint of the projection input
+UInt64 oProjector::GetInputFingerprint(BaseObject *mod, BaseDocument *doc, PointObject *op, BaseObject *collisionObject, const Float32 *weightMap)
+{
+	const Int32 pointCount = op->GetPointCount();
+
+	// Points of the deformed object
+	UInt64 fingerprint = HashMemory(op->GetPointR(), pointCount * sizeof(Vector));
+
+	// Matrices of all involved objects
+	const Matrix matrices[3] = { op->GetMg(), mod->GetMg(), collisionObject->GetMg() };
+	fingerprint = HashMemory(matrices, sizeof(matrices), fingerprint);
+
+	// Weight map from restriction tag
+	if (weightMap)
+		fingerprint = HashMemory(weightMap, pointCount * sizeof(Float32), fingerprint);
+
+	// Parameters, collision geometry, and falloff.
+	// The modifier's own dirty checksum can't be used here, as it is increased by every progressive refinement step.
+	UInt32 dirtyness = 0;
+	if (BaseContainer *bc = mod->GetDataInstance())
+		dirtyness += bc->GetDirty();
+	dirtyness += AddDirtySums(collisionObject, false, DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX|DIRTYFLAGS::CACHE);
+	dirtyness += AddDirtySums(collisionObject->GetDown(), true, DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX|DIRTYFLAGS::CACHE);
+	dirtyness += AddDirtySums(mod->GetUp(), false, DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX);
+	dirtyness += GetFalloffDirtyness(mod, doc);
+	return HashMemory(&dirtyness, sizeof(dirtyness), fingerprint);
+}
+
+// Project and write capture file
+Bool oProjector::CaptureEvaluation(const Filename &filename, PointObject *op, wsPointProjector &projector, const wsPointProjectorParams &params, const Matrix &collisionObjectMg, BaseThread *thread)
+{
+	// Keep the input points, they are part of the capture
+	const Int32 pointCount = op->GetPointCount();
+	maxon::BaseArray<Vector> inputPoints;
+	iferr (inputPoints.CopyFrom(maxon::ToBlock(op->GetPointR(), pointCount)))
+		return false;
+
+	// Full projection, no subsampling
+	if (!projector.Project(op, params, thread))
+		return false;
+
+	if (!filename.IsPopulated() || !_collision)
+		return false;
+
+	// The falloff values the projection sampled are written as they are, instead of sampling the falloff again
+	return WriteEvaluationCapture(filename, op, inputPoints.GetFirst(), params, projector.GetFalloffValues(), _collision->GetGeometry(), collisionObjectMg);
+}
+
+// Sample falloff at the points
+Bool oProjector::SampleFalloff(PointObject *op)
+{
+	const Int32 pointCount = op->GetPointCount();
+	iferr (_falloffValues.Resize(pointCount))
+		return false;
+
+	// Falloff is sampled at the original positions in global space, just like the projection does
+	const Matrix opMg = op->GetMg();
+	const Vector *padr = op->GetPointR();
+	for (Int32 i = 0; i < pointCount; ++i)
+	{
+		Float falloffResult = 1.0;
+		_falloff->Sample(opMg * padr[i], &falloffResult);
+		_falloffValues[i] = falloffResult;
+	}
+
+	return true;
+}
+
+// Compute fingerprint of the input of a baked frame
+UInt64 oProjector::GetBakeFingerprint(BaseObject *mod, PointObject *op, BaseObject *collisionObject, const BaseContainer &bc, const Float32 *weightMap, const Float *falloffValues)
+{
+	const Int32 pointCount = op->GetPointCount();
+
+	// Points of the deformed object
+	UInt64 fingerprint = HashMemory(&pointCount, sizeof(pointCount));
+	fingerprint = HashMemory(op->GetPointR(), pointCount * sizeof(Vector), fingerprint);
+
+	// Matrices of all involved objects
+	const Matrix matrices[3] = { op->GetMg(), mod->GetMg(), collisionObject->GetMg() };
+	fingerprint = HashMemory(matrices, sizeof(matrices), fingerprint);
+
+	// Weight map from restriction tag
+	if (weightMap)
+		fingerprint = HashMemory(weightMap, pointCount * sizeof(Float32), fingerprint);
+
+	// Falloff and fields, as the values they actually produce
+	if (falloffValues)
+		fingerprint = HashMemory(falloffValues, pointCount * sizeof(Float), fingerprint);
+
+	// Collision geometry, including generator caches, deformers and children. Hashing it is expensive, so it's only done again when the linked object has been changed.
+	const UInt64 collisionHashKey = GetCollisionDirtyness(collisionObject);
+	if (collisionHashKey != _collisionHashKey)
+	{
+		_collisionHash = HashGeometry(collisionObject);
+		_collisionHashKey = collisionHashKey;
+	}
+	fingerprint = HashMemory(&_collisionHash, sizeof(_collisionHash), fingerprint);
+
+	// Parameters that influence the result
+	const Float parameters[] =
+	{
+		(Float)bc.GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL),
+		(Float)bc.GetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD),
+		bc.GetFloat(PROJECTOR_OFFSET, 0.0),
+		bc.GetFloat(PROJECTOR_BLEND, 1.0),
+		bc.GetBool(PROJECTOR_GEOMFALLOFF_ENABLE, false) ? bc.GetFloat(PROJECTOR_GEOMFALLOFF_DIST, 100.0) : -1.0,
+		bc.GetBool(PROJECTOR_MAXDIST_ENABLE, false) ? bc.GetFloat(PROJECTOR_MAXDIST, 100.0) : -1.0,
+		bc.GetBool(PROJECTOR_SDF_ENABLE, false) ? (Float)bc.GetInt32(PROJECTOR_SDF_RESOLUTION, 128) : -1.0,
+		bc.GetBool(PROJECTOR_SPLINE_ADAPTIVE, false) ? bc.GetFloat(PROJECTOR_SPLINE_TOLERANCE, 1.0) : -1.0,
+		bc.GetBool(PROJECTOR_SPLINE_ADAPTIVE, false) ? (Float)bc.GetInt32(PROJECTOR_SPLINE_MAXDEPTH, 6) : -1.0
+	};
+	return HashMemory(parameters, sizeof(parameters), fingerprint);
+}
+
+// Bake frame range to point cache
+Bool oProjector::Bake(BaseObject *mod)
+{
+	BaseDocument *doc = mod ? mod->GetDocument() : nullptr;
+	BaseContainer *bc = mod ? mod->GetDataInstance() : nullptr;
+	if (!doc || !bc)
+		return false;
+
+	const Filename bakeFile = bc->GetFilename(PROJECTOR_BAKE_FILE);
+	const Int32 fromFrame = bc->GetInt32(PROJECTOR_BAKE_FROM, 0);
+	const Int32 toFrame = bc->GetInt32(PROJECTOR_BAKE_TO, 90);
+	const Float precision = bc->GetFloat(PROJECTOR_BAKE_PRECISION, 0.01);
+	if (!bakeFile.IsPopulated() || toFrame < fromFrame)
+		return false;
+
+	// The file might be open for playback
+	_pointCache.Close();
+
+	// Frames are evaluated in a clone of the document, so the user's document stays untouched
+	maxon::BaseArray<Int32> path;
+	if (!GetHierarchyPath(mod, path))
+		return false;
+
+	BaseDocument *bakeDoc = static_cast<BaseDocument*>(doc->GetClone(COPYFLAGS::DOCUMENT, nullptr));
+	if (!bakeDoc)
+		return false;
+
+	BaseObject *bakeMod = FindByHierarchyPath(bakeDoc, path);
+	oProjector *bakeProjector = bakeMod && bakeMod->GetType() == mod->GetType() ? bakeMod->GetNodeData<oProjector>() : nullptr;
+	wsPointCacheWriter writer;
+	if (!bakeProjector || !writer.Open(bakeFile, precision))
+	{
+		BaseDocument::Free(bakeDoc);
+		return false;
+	}
+
+	// The clone records the result of each evaluation. Its own modifier is set dirty, so it's evaluated in every frame, even if nothing else changed.
+	bakeProjector->_bakeWriter = &writer;
+	const Int32 fps = bakeDoc->GetFps();
+	Bool success = true;
+	for (Int32 frame = fromFrame; frame <= toFrame && success; ++frame)
+	{
+		// Escape cancels, the frames baked so far stay in the file
+		BaseContainer state;
+		if (GetInputState(BFM_INPUT_KEYBOARD, KEY_ESC, state) && state.GetInt32(BFM_INPUT_VALUE))
+		{
+			GePrint("PointProjector: Baking cancelled"_s);
+			success = false;
+			break;
+		}
+
+		StatusSetBar((Int32)(100 * (frame - fromFrame) / (toFrame - fromFrame + 1)));
+		bakeDoc->SetTime(BaseTime(frame, fps));
+		bakeMod->SetDirty(DIRTYFLAGS::DATA);
+		bakeProjector->_bakeEvaluations.StoreRelaxed(0);
+		success = bakeDoc->ExecutePasses(nullptr, true, true, true, BUILDFLAGS::EXTERNALRENDERER) && writer.GetFrameCount() == frame - fromFrame + 1;
+
+		// The point cache holds the points of one object. Playback would apply them to all objects the modifier deforms.
+		if (bakeProjector->_bakeEvaluations.LoadRelaxed() > 1)
+		{
+			GePrint("PointProjector: The modifier deforms more than one object, only a single object can be baked"_s);
+			success = false;
+		}
+	}
+	bakeProjector->_bakeWriter = nullptr;
+	success = writer.Close() && success;
+
+	if (writer.IsOutOfRange())
+		GePrint("PointProjector: Points moved too far for the Bake Precision, choose a coarser precision"_s);
+
+	BaseDocument::Free(bakeDoc);
+	StatusClear();
+	return success;
+}
+
 // Modify points of input object
 Bool oProjector::ModifyObject(BaseObject *mod, BaseDocument *doc, BaseObject *op, const Matrix &op_mg, const Matrix &mod_mg, Float lod, Int32 flags, BaseThread *thread)
 {
@@ -183,52 +612,185 @@ Bool oProjector::ModifyObject(BaseObject *mod, BaseDocument *doc, BaseObject *op
 	if (!collisionObject)
 		return true;
 
-	// Is it a polygon object?
-	Bool origCollisionObjectIsPoly = collisionObject->GetType() == Opolygon;
-	
-	// If it's not, we need to make it a proper polygon object
-	if (!origCollisionObjectIsPoly)
-	{
-		// Get real geometry
-		collisionObject = GetRealGeometry(collisionObject);
-		
-		// No chance, we give up
-		if (!collisionObject || collisionObject->GetType() != Opolygon)
-			return false;
-	}
-
 	// Get parameters
 	PROJECTORMODE mode = (PROJECTORMODE)bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL);
+	PROJECTORDIRECTION direction = (PROJECTORDIRECTION)bc->GetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD);
 	Float offset = bc->GetFloat(PROJECTOR_OFFSET, 0.0);
 	Float blend = bc->GetFloat(PROJECTOR_BLEND, 1.0);
 	Bool geometryFalloffEnabled = bc->GetBool(PROJECTOR_GEOMFALLOFF_ENABLE, false);
 	Float geometryFalloffDist = bc->GetFloat(PROJECTOR_GEOMFALLOFF_DIST, 100.0);
-	
-	// Calculate weight map from vertex maps linked in restriction tag
-	Float32* weightMap = nullptr;
-	weightMap = ToPoint(op)->CalcVertexMap(mod);
+	Float maxSearchDist = bc->GetBool(PROJECTOR_MAXDIST_ENABLE, false) ? bc->GetFloat(PROJECTOR_MAXDIST, 100.0) : 0.0;
+	Int32 sdfResolution = bc->GetBool(PROJECTOR_SDF_ENABLE, false) ? bc->GetInt32(PROJECTOR_SDF_RESOLUTION, 128) : 0;
+	const Bool renderEvaluation = IsRenderEvaluation(doc, flags);
+
+	// Get weight map from vertex maps linked in restriction tag
+	Float32 *weightMap = GetWeightMap(mod, ToPoint(op));
 
 	// Initialize falloff
 	if (!_falloff->InitFalloff(bc, doc, mod))
 		return false;
-	
-	// Initialize projector
-	if (!_projector.Init(static_cast<PolygonObject*>(collisionObject)))
-		return false;
+
+	// Baked frames are streamed from the point cache, as long as the input still matches what has been baked. Otherwise, the points are projected live.
+	// While baking, the input of each frame is fingerprinted, too. The falloff values are part of the fingerprint, the projection uses them as well.
+	const Bool usePointCache = !_bakeWriter && bc->GetBool(PROJECTOR_BAKE_USE, false);
+	const Int32 frame = doc ? doc->GetTime().GetFrame(doc->GetFps()) : 0;
+	UInt64 bakeFingerprint = 0;
+	const Float *falloffValues = nullptr;
+	if (usePointCache || _bakeWriter)
+	{
+		if (!SampleFalloff(ToPoint(op)))
+			return false;
+		falloffValues = _falloffValues.GetFirst();
+		bakeFingerprint = GetBakeFingerprint(mod, ToPoint(op), collisionObject, *bc, weightMap, falloffValues);
+	}
+	if (usePointCache)
+	{
+		const Filename bakeFile = bc->GetFilename(PROJECTOR_BAKE_FILE);
+		if (_pointCache.GetFilename() != bakeFile)
+			_pointCache.Open(bakeFile);
+
+		if (_pointCache.GetFrame(frame, bakeFingerprint, ToPoint(op)->GetPointW(), ToPoint(op)->GetPointCount()))
+		{
+			_progressive.Reset();
+			op->Message(MSG_UPDATE);
+			return true;
+		}
+	}
+
+	// Get collision geometry and acceleration structures
+	const UInt64 collisionChecksum = GetCollisionChecksum(collisionObject, *bc);
+	const BaseTime time = doc ? doc->GetTime() : BaseTime();
+	if (!renderEvaluation)
+	{
+		// Swap in the cache that has been built in the background, unless it's older than the current one
+		wsCollisionCache *builtCollision = _builder.TakeResult();
+		if (builtCollision && (!_collision || builtCollision->GetChecksum() == collisionChecksum || _collision->GetChecksum() != collisionChecksum))
+		{
+			DeleteObj(_collision);
+			_collision = builtCollision;
+		}
+		else
+		{
+			DeleteObj(builtCollision);
+		}
+	}
+
+	// Rendering can't wait for the background build, so the cache is built right away if necessary.
+	// The editor does the same as long as there is no cache at all (e.g. after opening the scene, copying, or undo), so the points don't pop back to their unprojected positions.
+	// It also does so when the time changed (playback, scrubbing) and the collision geometry is animated. A background build would be cancelled by the next frame, and never finish.
+	const Bool timeChanged = time != _evaluatedTime;
+	_evaluatedTime = time;
+	if (!_collision || (_collision->GetChecksum() != collisionChecksum && (renderEvaluation || timeChanged)))
+	{
+		DeleteObj(_collision);
+		_collision = NewObjClear(wsCollisionCache);
+		if (!_collision || !_collision->Build(collisionObject, collisionObject, mode, direction, sdfResolution, offset != 0.0, collisionChecksum, thread))
+		{
+			DeleteObj(_collision);
+			return false;
+		}
+		_requestedChecksum = collisionChecksum;
+	}
+	else if (!_collision->Supports(mode, direction, sdfResolution, offset != 0.0))
+	{
+		if (renderEvaluation)
+		{
+			// Rendering adds what the selected mode needs right away
+			if (!_collision->Extend(mode, direction, sdfResolution, offset != 0.0, thread))
+				return false;
+		}
+		else if (!_collision->Supports(mode, direction, 0, false))
+		{
+			// In the editor, CheckDirty() has requested a background build for the new parameters. Until it's swapped in, the points stay where they are.
+			// A distance field of another resolution, or missing smooth normals, don't stop the current cache from being used, though.
+			_progressive.Reset();
+			op->Message(MSG_UPDATE);
+			return true;
+		}
+	}
+
+	// The cached geometry follows the linked object. If another object has been linked, the previous geometry stays where it was until the new cache is swapped in.
+	if (_collision->GetLinkedObject() == collisionObject)
+		_collision->SetMg(collisionObject->GetMg());
+	wsPointProjector &projector = _collision->GetProjector();
+	const Matrix collisionObjectMg = _collision->GetGeometry()->GetMg();
 
 	// Parameters for projection
-	wsPointProjectorParams projectorParams(mod->GetMg(), mode, offset, blend, geometryFalloffEnabled, geometryFalloffDist, weightMap, _falloff);
-	
-	// Perform projection
-	if (!_projector.Project(static_cast<PointObject*>(op), projectorParams, thread))
-		return false;
+	wsPointProjectorParams projectorParams(mod->GetMg(), mode, direction, offset, blend, geometryFalloffEnabled, geometryFalloffDist, maxSearchDist, sdfResolution, weightMap, _falloff);
+	projectorParams._falloffValues = falloffValues;
 	
-	// Free collisionObject if we created it from the original collisionObject
-	if (!origCollisionObjectIsPoly)
-		BaseObject::Free(collisionObject);
-	
-	// Free weight map (important! Otherwise the memory fills up rather quickly)
-	DeleteMem(weightMap);
+	const Float editorQuality = ClampValue(bc->GetFloat(PROJECTOR_EDITOR_QUALITY, 1.0) * lod, 0.01, 1.0);
+	if (_captureRequested && !renderEvaluation)
+	{
+		// Capture this evaluation. It always gets a full projection, so it can be compared with a replay.
+		_captureRequested = false;
+		_progressive.Reset();
+		const Filename captureFile = bc->GetFilename(PROJECTOR_CAPTURE_FILE);
+		if (CaptureEvaluation(captureFile, ToPoint(op), projector, projectorParams, collisionObjectMg, thread))
+			GePrint("PointProjector: Evaluation captured to "_s + captureFile.GetString());
+		else
+			GePrint("PointProjector: Could not capture evaluation to "_s + captureFile.GetString());
+	}
+	else if (bc->GetBool(PROJECTOR_SPLINE_ADAPTIVE, false) && op->IsInstanceOf(Ospline) && ToSpline(op)->GetInterpolationType() == SPLINETYPE::LINEAR)
+	{
+		// Adaptive spline: Points are added where the projected linear spline would cut through the surface. Other spline types are projected as usual.
+		// The resampled spline depends on all of its points, so Editor Quality and Progressive don't apply.
+		_progressive.Reset();
+		const Float tolerance = Max(bc->GetFloat(PROJECTOR_SPLINE_TOLERANCE, 1.0), 0.001);
+		const Int32 maxDepth = bc->GetInt32(PROJECTOR_SPLINE_MAXDEPTH, 6);
+		if (!_resampler.Project(ToSpline(op), projector, projectorParams, tolerance, maxDepth, thread))
+			return false;
+	}
+	else if (bc->GetBool(PROJECTOR_PROGRESSIVE, false) && !renderEvaluation)
+	{
+		// Progressive projection in the editor: Show a coarse result right away, and refine it in the following evaluations.
+		// It also starts over when a new collision cache has been swapped in.
+		const UInt64 cacheChecksum = _collision->GetChecksum();
+		const UInt64 fingerprint = HashMemory(&cacheChecksum, sizeof(cacheChecksum), GetInputFingerprint(mod, doc, ToPoint(op), collisionObject, weightMap));
+		if (!_progressive.Update(projector, ToPoint(op), projectorParams, fingerprint, editorQuality, PROGRESSIVE_TIME_SLICE, thread))
+			return false;
+	}
+	else
+	{
+		_progressive.Reset();
+
+		// In the editor, only a subset of points might be projected, and the rest is interpolated.
+		// The fraction of projected points also follows the document's level of detail. Rendering and export always get full precision.
+		// The subsampler is only initialized again when its input changed, fitting the grid takes almost as long as the projection it saves.
+		wsPointSubsampler *subsampler = nullptr;
+		if (editorQuality < 1.0 && !renderEvaluation)
+		{
+			PointObject *pointOp = ToPoint(op);
+			const UInt64 subsamplerKey = GetSubsamplerKey(mod, pointOp, editorQuality);
+			if (subsamplerKey != _subsamplerKey || _subsampler.GetPointCount() != pointOp->GetPointCount())
+			{
+				_subsamplerKey = 0;
+				if (op->IsInstanceOf(Ospline))
+				{
+					// Splines: Every Nth point of each segment
+					SplineObject *splineOp = ToSpline(op);
+					if (!_subsampler.InitSegments(pointOp->GetPointCount(), splineOp->GetSegmentR(), splineOp->GetSegmentCount(), (Int32)Ceil(1.0 / editorQuality)))
+						return false;
+				}
+				else
+				{
+					// Everything else: A spatially stratified subset
+					if (!_subsampler.InitSpatial(pointOp->GetPointR(), pointOp->GetPointCount(), editorQuality))
+						return false;
+				}
+				_subsamplerKey = subsamplerKey;
+			}
+			subsampler = &_subsampler;
+		}
+
+		// Perform projection
+		if (!projector.Project(static_cast<PointObject*>(op), projectorParams, thread, subsampler))
+			return false;
+	}
+
+	// While baking, the result is recorded. Only the first deformed object is written, Bake() fails if there are more.
+	if (_bakeWriter && _bakeEvaluations.SwapIncrement() == 0)
+		_bakeWriter->AddFrame(frame, ToPoint(op)->GetPointR(), ToPoint(op)->GetPointCount(), bakeFingerprint);
 
 	// The object was probably deformed, so send update message
 	op->Message(MSG_UPDATE);
@@ -236,6 +798,61 @@ Bool oProjector::ModifyObject(BaseObject *mod, BaseDocument *doc, BaseObject *op
 	return true;
 }
 
+// Combine linked object and dirty checksums of its geometry
+UInt64 oProjector::GetCollisionDirtyness(BaseObject *collisionObject) const
+{
+	// Its own matrix doesn't matter, the cached geometry simply follows it
+	UInt32 dirtyness = collisionObject->GetDirty(DIRTYFLAGS::DATA|DIRTYFLAGS::CACHE);
+	dirtyness += AddDirtySums(collisionObject->GetDown(), true, DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX|DIRTYFLAGS::CACHE);
+	const UInt64 checksum = HashMemory(&collisionObject, sizeof(collisionObject));
+	return HashMemory(&dirtyness, sizeof(dirtyness), checksum);
+}
+
+// Compute key of the editor subsampler's input
+UInt64 oProjector::GetSubsamplerKey(BaseObject *mod, PointObject *op, Float editorQuality) const
+{
+	// Point count, segments and quality determine which points are selected
+	const Int32 pointCount = op->GetPointCount();
+	UInt64 key = HashMemory(&pointCount, sizeof(pointCount));
+	key = HashMemory(&editorQuality, sizeof(editorQuality), key);
+	if (op->IsInstanceOf(Ospline))
+	{
+		SplineObject *splineOp = ToSpline(op);
+		if (splineOp->GetSegmentR())
+			key = HashMemory(splineOp->GetSegmentR(), splineOp->GetSegmentCount() * sizeof(Segment), key);
+	}
+
+	// The interpolation weights depend on the positions. They change with the deformed object, and with the deformers evaluated before this one.
+	// Hashing the positions themselves would cost almost as much as initializing the subsampler.
+	UInt32 dirtyness = 0;
+	if (BaseObject *parent = mod->GetUp())
+		dirtyness += parent->GetDirty(DIRTYFLAGS::DATA|DIRTYFLAGS::CACHE);
+	for (BaseObject *deformer = mod->GetPred(); deformer; deformer = deformer->GetPred())
+		dirtyness += deformer->GetDirty(DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX);
+	key = HashMemory(&dirtyness, sizeof(dirtyness), key);
+
+	// 0 means there is no key
+	return key != 0 ? key : 1;
+}
+
+// Compute checksum of collision cache input
+UInt64 oProjector::GetCollisionChecksum(BaseObject *collisionObject, const BaseContainer &bc) const
+{
+	// Linked object and its geometry
+	const UInt64 checksum = GetCollisionDirtyness(collisionObject);
+
+	// Acceleration structures needed by the parameters. Switching e.g. between parallel and spherical mode doesn't need a new cache.
+	// Only turning the offset on or off matters, it needs the vertex normals. So dragging it doesn't start a background build.
+	const Int32 mode = bc.GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL);
+	const Int32 structures[3] =
+	{
+		mode == PROJECTOR_MODE_CLOSEST || bc.GetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD) != PROJECTOR_DIRECTION_FORWARD,
+		(mode == PROJECTOR_MODE_CLOSEST && bc.GetBool(PROJECTOR_SDF_ENABLE, false)) ? bc.GetInt32(PROJECTOR_SDF_RESOLUTION, 128) : 0,
+		bc.GetFloat(PROJECTOR_OFFSET, 0.0) != 0.0
+	};
+	return HashMemory(structures, sizeof(structures), checksum);
+}
+
 // Check if modifier or linked object have been changed in any way
 // If so, set the modifier dirty, which will trigger a recalculation
 void oProjector::CheckDirty(BaseObject *op, BaseDocument *doc)
@@ -269,52 +886,32 @@ void oProjector::CheckDirty(BaseObject *op, BaseDocument *doc)
 	// Iterate modifier and its parents and add their dirty checksums
 	dirtyness += AddDirtySums(op, false, dirtyFlags);
 
-#if API_VERSION >= 23000
 	// Add falloff dirtiness
-	if (_falloff)
-	{
-		dirtyness += _falloff->GetDirty(doc);
+	dirtyness += GetFalloffDirtyness(op, doc);
 
-		// Check for dirty fields
-		GeData geFieldData;
-		if (op->GetParameter(FIELDS, geFieldData, DESCFLAGS_GET::NONE))
+	// In the editor, the collision cache is built in the background when the linked object or its geometry changed.
+	// A new request cancels the build that is still running. Documents that are rendered build their cache right away in ModifyObject().
+	// The first cache, and the caches during playback and scrubbing, are built right away in ModifyObject(), too. Requesting a background build for every frame would only clone the linked object in vain.
+	if (!IsRenderEvaluation(doc, 0) && _collision && doc->GetTime() == _evaluatedTime && !CheckIsRunning(CHECKISRUNNING::ANIMATIONRUNNING))
+	{
+		const UInt64 collisionChecksum = GetCollisionChecksum(collisionObject, *bc);
+		if (collisionChecksum != _requestedChecksum)
 		{
-			// Get FieldList
-			CustomDataType* const fieldData = geFieldData.GetCustomDataType(CUSTOMDATATYPE_FIELDLIST);
-			FieldList* const fieldList  = static_cast<FieldList*>(fieldData);
-			if (fieldList)
-			{
-				dirtyness += fieldList->GetDirty(doc);
-
-				if (fieldList->HasContent())
-				{
-					// Dirty field objects
-					GeListHead *listHead = fieldList->GetLayersRoot();
-					if (listHead)
-					{
-						for (FieldLayer *layer = static_cast<FieldLayer*>(listHead->GetFirst()); layer; layer = IterateNextFieldLayer(layer))
-						{
-							// Layer node (in list)
-							dirtyness += layer->GetDirty(DIRTYFLAGS::DATA);
-
-							// Actual field object
-							const FieldLayerLink layerLink = layer->GetLinkedObject(doc);
-							BaseObject *fieldObject = static_cast<BaseObject*>(layerLink._object);
-							if (fieldObject)
-							{
-								dirtyness += fieldObject->GetDirty(DIRTYFLAGS::CACHE|DIRTYFLAGS::DATA|DIRTYFLAGS::MATRIX);
-							}
-						}
-					}
-				}
-			}
+			PROJECTORMODE mode = (PROJECTORMODE)bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL);
+			PROJECTORDIRECTION direction = (PROJECTORDIRECTION)bc->GetInt32(PROJECTOR_DIRECTION, PROJECTOR_DIRECTION_FORWARD);
+			Int32 sdfResolution = bc->GetBool(PROJECTOR_SDF_ENABLE, false) ? bc->GetInt32(PROJECTOR_SDF_RESOLUTION, 128) : 0;
+			Bool smoothNormals = bc->GetFloat(PROJECTOR_OFFSET, 0.0) != 0.0;
+			if (_builder.RequestBuild(collisionObject, mode, direction, sdfResolution, smoothNormals, collisionChecksum))
+				_requestedChecksum = collisionChecksum;
 		}
 
+		// Start the latest request, if the previous build has finished in the meantime
+		_builder.StartPending();
 	}
-#endif
 
-	// Compare dirty checksum to previous one, set modifier dirty if necessary
-	if (dirtyness != _lastDirtyness + 1)
+	// Compare dirty checksum to previous one, set modifier dirty if necessary.
+	// A collision cache that has been built in the background is swapped in by the next evaluation, too.
+	if (dirtyness != _lastDirtyness + 1 || _builder.HasResult())
 	{
 		// Store dirty checksum for next comparison
 		_lastDirtyness = dirtyness;
@@ -322,6 +919,14 @@ void oProjector::CheckDirty(BaseObject *op, BaseDocument *doc)
 		// Set modifier dirty. It will be recalculated.
 		op->SetDirty(DIRTYFLAGS::DATA);
 	}
+	else if (_progressive.IsRefining())
+	{
+		// Progressive projection isn't finished yet, ask for another evaluation.
+		// SetDirty() increases the modifier's own checksum by one, which is what the comparison above expects.
+		_lastDirtyness = dirtyness;
+		op->SetDirty(DIRTYFLAGS::DATA);
+		EventAdd();
+	}
 }
 
 // Copy private data
@@ -389,6 +994,41 @@ Bool oProjector::GetDEnabling(GeListNode *node, const DescID &id, const GeData &
 		// Only enable geometry falloff distance parameter of geometry falloff is active
 		case PROJECTOR_GEOMFALLOFF_DIST:
 			return bc->GetBool(PROJECTOR_GEOMFALLOFF_ENABLE, false);
+
+		// Direction is only used in the ray modes
+		case PROJECTOR_DIRECTION:
+			return bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL) != PROJECTOR_MODE_CLOSEST;
+
+		// Search radius is only used in closest point mode
+		case PROJECTOR_MAXDIST_ENABLE:
+			return bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL) == PROJECTOR_MODE_CLOSEST;
+
+		case PROJECTOR_MAXDIST:
+			return bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL) == PROJECTOR_MODE_CLOSEST && bc->GetBool(PROJECTOR_MAXDIST_ENABLE, false);
+
+		// Distance field is only used in closest point mode
+		case PROJECTOR_SDF_ENABLE:
+			return bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL) == PROJECTOR_MODE_CLOSEST;
+
+		case PROJECTOR_SDF_RESOLUTION:
+			return bc->GetInt32(PROJECTOR_MODE, PROJECTOR_MODE_PARALLEL) == PROJECTOR_MODE_CLOSEST && bc->GetBool(PROJECTOR_SDF_ENABLE, false);
+
+		// Tolerance and subdivisions are only used for adaptive splines
+		case PROJECTOR_SPLINE_TOLERANCE:
+		case PROJECTOR_SPLINE_MAXDEPTH:
+			return bc->GetBool(PROJECTOR_SPLINE_ADAPTIVE, false);
+
+		// Capturing needs a file
+		case PROJECTOR_CAPTURE:
+			return bc->GetFilename(PROJECTOR_CAPTURE_FILE).IsPopulated();
+
+		// Baking and playback need a point cache file
+		case PROJECTOR_BAKE:
+			return bc->GetFilename(PROJECTOR_BAKE_FILE).IsPopulated() && bc->GetInt32(PROJECTOR_BAKE_TO, 90) >= bc->GetInt32(PROJECTOR_BAKE_FROM, 0);
+
+		case PROJECTOR_BAKE_PRECISION:
+		case PROJECTOR_BAKE_USE:
+			return bc->GetFilename(PROJECTOR_BAKE_FILE).IsPopulated();
 	}
 	
 	return SUPER::GetDEnabling(node, id, t_data, flags, itemdesc);